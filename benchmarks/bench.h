@@ -0,0 +1,107 @@
+// bench.h
+// Minimal microbenchmark harness: ns/op, allocations/op and throughput, with JSON output.
+//
+//   BENCHMARK("protocol/serialize_game_message", [](bench::State& st) {
+//       GameMessage m{};                 // setup is not timed
+//       for (auto _ : st) { ... }        // only the loop is timed
+//   });
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// Incremented by the global operator new override in bench_main.cpp.
+extern std::atomic<uint64_t> g_alloc_count;
+
+template <typename T>
+inline void do_not_optimize(T const& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+class State {
+public:
+    explicit State(uint64_t iterations) : iterations_(iterations) {}
+
+    // Non-trivial so `for (auto _ : st)` does not trip -Wunused-variable
+    struct Value { ~Value() {} };
+
+    struct Iterator {
+        State* st;
+        uint64_t remaining;
+        bool operator!=(const Iterator&) {
+            if (remaining != 0) return true;
+            st->stop();
+            return false;
+        }
+        void operator++() { --remaining; }
+        Value operator*() const { return {}; }
+    };
+
+    Iterator begin() { start(); return { this, iterations_ }; }
+    Iterator end() { return { this, 0 }; }
+
+    uint64_t iterations() const { return iterations_; }
+
+    // Work items processed per iteration (e.g. players per tick), for throughput
+    void set_items_per_op(double n) { items_per_op_ = n; }
+    void set_bytes_per_op(double n) { bytes_per_op_ = n; }
+
+    double elapsed_ns() const { return elapsed_ns_; }
+    uint64_t allocations() const { return allocs_; }
+    double items_per_op() const { return items_per_op_; }
+    double bytes_per_op() const { return bytes_per_op_; }
+
+private:
+    void start() {
+        allocs_start_ = g_alloc_count.load(std::memory_order_relaxed);
+        t0_ = std::chrono::steady_clock::now();
+    }
+    void stop() {
+        auto t1 = std::chrono::steady_clock::now();
+        allocs_ = g_alloc_count.load(std::memory_order_relaxed) - allocs_start_;
+        elapsed_ns_ = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0_).count());
+    }
+
+    uint64_t iterations_;
+    std::chrono::steady_clock::time_point t0_{};
+    uint64_t allocs_start_ = 0;
+    uint64_t allocs_ = 0;
+    double elapsed_ns_ = 0.0;
+    double items_per_op_ = 1.0;
+    double bytes_per_op_ = 0.0;
+};
+
+using Fn = std::function<void(State&)>;
+
+struct Entry {
+    std::string name;
+    Fn fn;
+};
+
+inline std::vector<Entry>& registry() {
+    static std::vector<Entry> r;
+    return r;
+}
+
+struct Registrar {
+    Registrar(const char* name, Fn fn) { registry().push_back({ name, std::move(fn) }); }
+};
+
+} // namespace bench
+
+#define BENCH_CONCAT_(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_(a, b)
+#define BENCHMARK(name, ...) \
+    static ::bench::Registrar BENCH_CONCAT(bench_registrar_, __LINE__)(name, __VA_ARGS__)
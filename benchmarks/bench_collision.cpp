@@ -0,0 +1,72 @@
+// bench_collision.cpp
+// AABB overlap and hitscan at scale; numbers are per pairwise test.
+
+#include "bench.h"
+#include "Collision.h"
+
+#include <random>
+
+namespace {
+
+constexpr int kBodies = 1024;
+
+std::vector<glm::vec3> random_positions(int n, float extent) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> d(-extent, extent);
+    std::vector<glm::vec3> out;
+    out.reserve(n);
+    for (int i = 0; i < n; ++i) out.emplace_back(d(rng), 0.0f, d(rng));
+    return out;
+}
+
+std::vector<AABB> random_boxes(int n, float extent) {
+    std::vector<AABB> out;
+    out.reserve(n);
+    const glm::vec3 half(0.5f, 1.0f, 0.5f);
+    for (const auto& p : random_positions(n, extent)) out.push_back({ p - half, p + half });
+    return out;
+}
+
+} // namespace
+
+BENCHMARK("collision/aabb_overlap_all_pairs_1024", [](bench::State& st) {
+    const auto boxes = random_boxes(kBodies, 20.0f);
+    st.set_items_per_op(static_cast<double>(kBodies) * (kBodies - 1) / 2);
+    for (auto _ : st) {
+        int hits = 0;
+        for (int i = 0; i < kBodies; ++i)
+            for (int j = i + 1; j < kBodies; ++j)
+                hits += aabb_overlap(boxes[i], boxes[j]) ? 1 : 0;
+        bench::do_not_optimize(hits);
+    }
+});
+
+BENCHMARK("collision/aabb_vs_world_1024", [](bench::State& st) {
+    const auto boxes = random_boxes(kBodies, 20.0f);
+    // Same colliders as Game's world
+    const std::vector<AABB> world = {
+        {{ -20.f, -1.5f, -20.f }, { 20.f, -0.5f, 20.f }},
+        {{ -5.f, -0.5f, -5.f },  { -3.f,  1.5f, -3.f }},
+        {{  3.f, -0.5f,  4.f },  {  5.f,  1.5f,  6.f }},
+    };
+    st.set_items_per_op(static_cast<double>(kBodies) * world.size());
+    for (auto _ : st) {
+        int hits = 0;
+        for (const auto& b : boxes)
+            for (const auto& c : world)
+                hits += aabb_overlap(b, c) ? 1 : 0;
+        bench::do_not_optimize(hits);
+    }
+});
+
+BENCHMARK("collision/hitscan_loop_1024", [](bench::State& st) {
+    const auto targets = random_positions(kBodies, 40.0f);
+    const glm::vec3 origin(0.0f, 0.0f, 0.0f);
+    const glm::vec3 forward(0.0f, 0.0f, -1.0f);
+    st.set_items_per_op(kBodies);
+    for (auto _ : st) {
+        int hits = 0;
+        for (const auto& t : targets) hits += hitscan_hits(origin, forward, t) ? 1 : 0;
+        bench::do_not_optimize(hits);
+    }
+});
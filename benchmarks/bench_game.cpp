@@ -0,0 +1,118 @@
+// bench_game.cpp
+// GameMap loading/queries and the full server tick with N headless players.
+
+#include "bench.h"
+#include "Game.h"
+#include "GameMap.h"
+#include "input_frames.h"
+#include "map_data.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+// GameMap::load reports to std::cout; keep the benchmark table readable
+struct SilenceCout {
+    std::ostringstream sink;
+    std::streambuf* old = std::cout.rdbuf(sink.rdbuf());
+    ~SilenceCout() { std::cout.rdbuf(old); }
+};
+
+std::string write_embedded_map() {
+    std::string path = "bench_map.txt";
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(map_txt), map_txt_len);
+    return path;
+}
+
+void bench_tick(bench::State& st, int players) {
+    boost::asio::io_context io; // never run: the tick is driven directly
+    Game game(io, 0, 0);
+
+    std::vector<uint32_t> ids;
+    for (int i = 0; i < players; ++i) ids.push_back(game.add_local_player());
+
+    GameMessage ready{};
+    ready.type = MessageType::ClientReady;
+    ready.setData(ClientReadyData{});
+    for (auto id : ids) game.handle_msg(id, ready);
+    game.tick(); // LOBBY -> IN_PROGRESS once everyone is ready
+
+    // Random spawns stand in the ground slab and on each other, and every move into a
+    // collider is reverted. Start on a grid above the boxes so the tick moves players.
+    for (int i = 0; i < players; ++i)
+        game.place_player(ids[i], glm::vec3(2.0f * static_cast<float>(i % 8) - 7.0f, 3.0f,
+                                            2.0f * static_cast<float>(i / 8) - 7.0f));
+
+    // What clients send: one PlayerInputFrames message per tick, applied by tick() from
+    // the player's input queue
+    std::vector<InputFrameHistory> history(ids.size());
+    PlayerInputData in{};
+    in.up = true;
+    auto send_inputs = [&](uint64_t frame) {
+        // Turn a little each frame so players circle instead of running off in a line
+        in.rotation = glm::quat(glm::vec3(0.0f, 0.05f * static_cast<float>(frame % 128), 0.0f));
+        for (std::size_t i = 0; i < ids.size(); ++i) {
+            history[i].push(in);
+            game.handle_msg(ids[i], history[i].make_message());
+        }
+    };
+
+    const glm::vec3 start = game.player_position(ids.front());
+    send_inputs(0);
+    game.tick();
+    if (game.player_position(ids.front()) == start)
+        std::cerr << "game/tick_loop: players did not move, the benchmark measures collision rejection\n";
+
+    st.set_items_per_op(players);
+    uint64_t frame = 1;
+    for (auto _ : st) {
+        send_inputs(frame++);
+        game.tick();
+    }
+}
+
+} // namespace
+
+BENCHMARK("map/load", [](bench::State& st) {
+    const std::string path = write_embedded_map();
+    SilenceCout quiet;
+    GameMap map;
+    std::vector<std::vector<int>> layout;
+    st.set_bytes_per_op(map_txt_len);
+    for (auto _ : st) {
+        bool ok = map.load(path, layout);
+        bench::do_not_optimize(ok);
+    }
+    std::remove(path.c_str());
+});
+
+BENCHMARK("map/is_walkable_full_scan", [](bench::State& st) {
+    const std::string path = write_embedded_map();
+    GameMap map;
+    std::vector<std::vector<int>> layout;
+    {
+        SilenceCout quiet;
+        map.load(path, layout);
+    }
+    std::remove(path.c_str());
+
+    const int h = static_cast<int>(layout.size());
+    const int w = h ? static_cast<int>(layout[0].size()) : 0;
+    st.set_items_per_op(static_cast<double>(w) * h);
+    for (auto _ : st) {
+        int walkable = 0;
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                walkable += map.is_walkable(x, y) ? 1 : 0;
+        bench::do_not_optimize(walkable);
+    }
+});
+
+BENCHMARK("game/tick_loop_players_2", [](bench::State& st) { bench_tick(st, 2); });
+BENCHMARK("game/tick_loop_players_16", [](bench::State& st) { bench_tick(st, 16); });
+BENCHMARK("game/tick_loop_players_64", [](bench::State& st) { bench_tick(st, 64); });
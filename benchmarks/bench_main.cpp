@@ -0,0 +1,129 @@
+// bench_main.cpp
+// Benchmark runner. Usage:
+//   ./benchmarks [--filter <substring>] [--min-time-ms <ms>] [--json <file|->]
+
+#include "bench.h"
+#include "log.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+
+// ---------------------- Allocation counting ----------------------
+
+std::atomic<uint64_t> bench::g_alloc_count{0};
+
+void* operator new(std::size_t n) {
+    bench::g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) {
+    bench::g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+// ---------------------- Runner ----------------------
+
+namespace {
+
+struct Result {
+    std::string name;
+    uint64_t iterations = 0;
+    double ns_per_op = 0.0;
+    double allocs_per_op = 0.0;
+    double items_per_sec = 0.0;
+    double bytes_per_sec = 0.0;
+};
+
+Result run_one(const bench::Entry& e, double min_time_ns) {
+    uint64_t iters = 1;
+    for (;;) {
+        bench::State st(iters);
+        e.fn(st);
+
+        double elapsed = st.elapsed_ns() > 0.0 ? st.elapsed_ns() : 1.0;
+        if (elapsed >= min_time_ns || iters >= 1000000000ull) {
+            Result r;
+            r.name = e.name;
+            r.iterations = iters;
+            r.ns_per_op = elapsed / static_cast<double>(iters);
+            r.allocs_per_op = static_cast<double>(st.allocations()) / static_cast<double>(iters);
+            r.items_per_sec = st.items_per_op() * static_cast<double>(iters) * 1e9 / elapsed;
+            r.bytes_per_sec = st.bytes_per_op() * static_cast<double>(iters) * 1e9 / elapsed;
+            return r;
+        }
+
+        // Grow towards min_time with some headroom, at least doubling
+        double scale = (min_time_ns / elapsed) * 1.4;
+        if (scale < 2.0) scale = 2.0;
+        if (scale > 100.0) scale = 100.0;
+        iters = static_cast<uint64_t>(static_cast<double>(iters) * scale);
+    }
+}
+
+std::string to_json(const std::vector<Result>& results) {
+    std::ostringstream os;
+    os << "{\n  \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        os << "    {\"name\": \"" << r.name << "\""
+           << ", \"iterations\": " << r.iterations
+           << ", \"ns_per_op\": " << r.ns_per_op
+           << ", \"allocs_per_op\": " << r.allocs_per_op
+           << ", \"items_per_sec\": " << r.items_per_sec
+           << ", \"bytes_per_sec\": " << r.bytes_per_sec
+           << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+    return os.str();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string filter;
+    std::string json_path;
+    double min_time_ms = 200.0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--filter") && i + 1 < argc) filter = argv[++i];
+        else if (!std::strcmp(argv[i], "--min-time-ms") && i + 1 < argc) min_time_ms = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--json") && i + 1 < argc) json_path = argv[++i];
+        else {
+            std::cerr << "usage: " << argv[0] << " [--filter <substring>] [--min-time-ms <ms>] [--json <file|->]\n";
+            return 2;
+        }
+    }
+
+    // Game logs joins at Info; keep the table and the allocation counts free of log traffic
+    logging::set_level(logging::Level::Warn);
+
+    std::vector<Result> results;
+    std::printf("%-44s %14s %12s %12s %14s\n", "benchmark", "iterations", "ns/op", "allocs/op", "items/s");
+    for (const auto& e : bench::registry()) {
+        if (!filter.empty() && e.name.find(filter) == std::string::npos) continue;
+        Result r = run_one(e, min_time_ms * 1e6);
+        std::printf("%-44s %14llu %12.1f %12.2f %14.4g\n", r.name.c_str(),
+                    static_cast<unsigned long long>(r.iterations), r.ns_per_op, r.allocs_per_op, r.items_per_sec);
+        results.push_back(r);
+    }
+
+    if (json_path == "-") {
+        std::cout << to_json(results);
+    } else if (!json_path.empty()) {
+        std::ofstream out(json_path);
+        if (!out) { std::cerr << "Error: Could not open " << json_path << "\n"; return 1; }
+        out << to_json(results);
+    }
+    return 0;
+}
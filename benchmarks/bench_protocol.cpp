@@ -0,0 +1,113 @@
+// bench_protocol.cpp
+// Wire format: TCP body encode/decode, GameMessage payload access, UDP datagrams and packets.
+
+#include "bench.h"
+#include "Serialization.h"
+
+namespace {
+
+AllPlayersStateData make_full_batch() {
+    AllPlayersStateData batch{};
+    batch.count = MAX_PLAYERS;
+    for (int i = 0; i < MAX_PLAYERS; ++i) {
+        glm::vec3 pos(static_cast<float>(i), 0.0f, static_cast<float>(-i));
+        batch.players[i] = PlayerStateData{ static_cast<uint32_t>(i + 1), pos, glm::quat(1, 0, 0, 0),
+                                            pos - glm::vec3(0.5f, 1.0f, 0.5f), pos + glm::vec3(0.5f, 1.0f, 0.5f),
+                                            100, 0, 0, true };
+    }
+    return batch;
+}
+
+} // namespace
+
+BENCHMARK("protocol/serialize_game_message", [](bench::State& st) {
+    GameMessage m{};
+    m.type = MessageType::PlayerState;
+    m.setData(make_full_batch());
+    st.set_bytes_per_op(sizeof(uint32_t) + sizeof(m.data));
+    for (auto _ : st) {
+        auto body = serialize_game_message(m);
+        bench::do_not_optimize(body.data());
+    }
+});
+
+BENCHMARK("protocol/deserialize_game_message", [](bench::State& st) {
+    GameMessage m{};
+    m.type = MessageType::PlayerState;
+    m.setData(make_full_batch());
+    const auto body = serialize_game_message(m);
+    st.set_bytes_per_op(static_cast<double>(body.size()));
+    for (auto _ : st) {
+        GameMessage out = deserialize_game_message(body);
+        bench::do_not_optimize(out);
+    }
+});
+
+BENCHMARK("protocol/setData_AllPlayersState", [](bench::State& st) {
+    const auto batch = make_full_batch();
+    GameMessage m{};
+    st.set_bytes_per_op(sizeof(batch));
+    for (auto _ : st) {
+        m.setData(batch);
+        bench::do_not_optimize(m);
+    }
+});
+
+BENCHMARK("protocol/getData_AllPlayersState", [](bench::State& st) {
+    GameMessage m{};
+    m.setData(make_full_batch());
+    st.set_bytes_per_op(sizeof(AllPlayersStateData));
+    for (auto _ : st) {
+        auto batch = m.getData<AllPlayersStateData>();
+        bench::do_not_optimize(batch);
+    }
+});
+
+BENCHMARK("protocol/setData_getData_PlayerInput", [](bench::State& st) {
+    PlayerInputData in{};
+    in.up = true;
+    GameMessage m{};
+    for (auto _ : st) {
+        m.setData(in);
+        auto out = m.getData<PlayerInputData>();
+        bench::do_not_optimize(out);
+    }
+});
+
+BENCHMARK("protocol/udp_encode", [](bench::State& st) {
+    UDPMessage u{ 7, glm::vec3(1.0f, 2.0f, 3.0f), glm::quat(1, 0, 0, 0) };
+    st.set_bytes_per_op(sizeof(UDPMessage));
+    for (auto _ : st) {
+        auto buf = serialize_udp_message(u);
+        bench::do_not_optimize(buf.data());
+    }
+});
+
+BENCHMARK("protocol/udp_decode", [](bench::State& st) {
+    UDPMessage u{ 7, glm::vec3(1.0f, 2.0f, 3.0f), glm::quat(1, 0, 0, 0) };
+    const auto buf = serialize_udp_message(u);
+    st.set_bytes_per_op(sizeof(UDPMessage));
+    for (auto _ : st) {
+        auto out = deserialize_udp_message(buf.data(), buf.size());
+        bench::do_not_optimize(out);
+    }
+});
+
+BENCHMARK("protocol/reliable_state_packet_roundtrip", [](bench::State& st) {
+    // One server tick for one peer: queue the state batch, build the packet, peer parses it
+    ReliableEndpoint server, client;
+    GameMessage ps{};
+    ps.type = MessageType::PlayerState;
+    ps.setData(make_full_batch());
+    std::vector<char> packet(kMaxPacketSize);
+    auto now = std::chrono::steady_clock::now();
+    std::size_t delivered = 0;
+    st.set_bytes_per_op(sizeof(AllPlayersStateData));
+    for (auto _ : st) {
+        server.send(Channel::Unreliable, ps);
+        std::size_t n = server.write_packet(now, packet.data(), packet.size());
+        client.read_packet(packet.data(), n, now, [&](const GameMessage&) { ++delivered; });
+        now += std::chrono::milliseconds(16);
+    }
+    bench::do_not_optimize(delivered);
+});
@@ -1,57 +1,116 @@
 #include "NetworkClient.h"
-#include <iostream>
+#include <algorithm>
+#include <cstddef>
 #include <cstring>
 
+#include "../shared/log.h"
+
 using boost::asio::ip::tcp;
 using boost::asio::ip::udp;
 
 NetworkClient::NetworkClient(boost::asio::io_context& io)
     : io_context(io),
       tcp_socket(io),
-      udp_socket(io) {}
+      udp_socket(io),
+      udp_flush_timer_(io) {
+    // Room for a burst of TCP frames before the buffers ever grow
+    tcp_pending_.reserve(8 * (header_length + GameMessage::kWireSize));
+    tcp_inflight_.reserve(8 * (header_length + GameMessage::kWireSize));
+}
 
 void NetworkClient::connect(const std::string& host, const std::string& port) {
     tcp::resolver resolver(io_context);
     auto endpoints = resolver.resolve(host, port);
     boost::asio::async_connect(tcp_socket, endpoints,
-        [this, host](boost::system::error_code ec, tcp::endpoint) {
+        [this](boost::system::error_code ec, tcp::endpoint) {
             if (!ec) {
-                std::cout << "[Client] Connected to server via TCP.\n";
+                LOG_INFO("[Client] Connected to server via TCP.");
                 do_read_header();
-                start_udp(host);
+
+                // UDP starts once the server answers with our slot and token
+                const HandshakeData hs{ static_cast<uint32_t>(GAME_VERSION) };
+                queue_tcp(MessageType::Handshake, reinterpret_cast<const char*>(&hs), sizeof(hs));
             } else {
-                std::cerr << "[Client] TCP Connect failed: " << ec.message() << "\n";
+                LOG_ERROR("[Client] TCP Connect failed: {}", ec.message());
             }
         });
 }
 
 void NetworkClient::close() {
     boost::system::error_code ec;
+    udp_flush_timer_.cancel();
     tcp_socket.close(ec);
     udp_socket.close(ec);
     if (ec) {
-        std::cerr << "[Client] Error closing sockets: " << ec.message() << "\n";
+        LOG_ERROR("[Client] Error closing sockets: {}", ec.message());
     }
 }
 
-void NetworkClient::send_tcp(const GameMessage& msg) {
-    boost::asio::post(io_context, [this, msg]() {
-        bool write_in_progress = !write_msgs.empty();
-        write_msgs.push_back(msg);
-        if (!write_in_progress) {
-            do_write();
-        }
-    });
+bool NetworkClient::send(const GameMessage& msg) {
+    const std::size_t size = message_wire_size(msg);
+    OutgoingMessage out;
+    if (size > sizeof(out.data)) {
+        LOG_ERROR("[Client] {} payload too large to send ({} bytes)", message_type_name(msg.type), size);
+        return false;
+    }
+    out.type = msg.type;
+    out.size = static_cast<uint16_t>(size);
+    std::memcpy(out.data, msg.data, size);
+    if (!outgoing_.try_push(out)) {
+        LOG_WARN("[Client] Outgoing ring full, dropped {}", message_type_name(msg.type));
+        return false;
+    }
+    if (!drain_posted_.exchange(true, std::memory_order_acq_rel)) {
+        boost::asio::post(io_context, DrainHandler{ this });
+    }
+    return true;
 }
 
-void NetworkClient::send_udp(const UDPMessage& msg) {
-    std::vector<char> buffer(sizeof(UDPMessage));
-    std::memcpy(buffer.data(), &msg, sizeof(UDPMessage));
+void NetworkClient::drain_outgoing() {
+    // Clear the flag first: a push that finds it clear posts another drain, one that
+    // finds it set is seen by the loop below
+    drain_posted_.exchange(false, std::memory_order_acq_rel);
+    OutgoingMessage out;
+    while (outgoing_.try_pop(out)) send_now(out.type, out.data, out.size);
+}
 
-    udp_socket.async_send_to(boost::asio::buffer(buffer), server_udp_endpoint,
-        [](boost::system::error_code ec, std::size_t /*bytes_sent*/) {
-            if (ec) {
-                std::cerr << "[Client] UDP send error: " << ec.message() << "\n";
+void NetworkClient::send_now(MessageType type, const char* payload, std::size_t size) {
+    Channel ch;
+    if (udp_conn_ && udp_channel_for(type, ch) && udp_conn_->send(ch, type, payload, size)) {
+        if (ch != Channel::Unreliable) flush_udp(); // don't hold reliable commands for the next flush
+        return;
+    }
+    queue_tcp(type, payload, size);
+}
+
+void NetworkClient::queue_tcp(MessageType type, const char* payload, std::size_t size) {
+    // Frame: u32 body length, u32 type, payload zero-padded to GameMessage::data
+    const uint32_t body_length = static_cast<uint32_t>(GameMessage::kWireSize);
+    const uint32_t t = static_cast<uint32_t>(type);
+    const std::size_t at = tcp_pending_.size();
+    tcp_pending_.resize(at + header_length + GameMessage::kWireSize); // value-initialised: padding is zero
+    char* frame = tcp_pending_.data() + at;
+    std::memcpy(frame, &body_length, sizeof(uint32_t));
+    std::memcpy(frame + header_length, &t, sizeof(uint32_t));
+    std::memcpy(frame + header_length + sizeof(uint32_t), payload, size);
+
+    if (!tcp_write_in_progress_) start_tcp_write();
+}
+
+void NetworkClient::start_tcp_write() {
+    if (tcp_pending_.empty()) return;
+    tcp_inflight_.swap(tcp_pending_);
+    tcp_pending_.clear();
+    tcp_write_in_progress_ = true;
+
+    boost::asio::async_write(tcp_socket, boost::asio::buffer(tcp_inflight_),
+        [this](boost::system::error_code ec, std::size_t /*length*/) {
+            tcp_write_in_progress_ = false;
+            if (!ec) {
+                start_tcp_write();
+            } else {
+                if (ec != boost::asio::error::operation_aborted) LOG_ERROR("[Client] TCP write error: {}", ec.message());
+                tcp_socket.close(ec);
             }
         });
 }
@@ -62,10 +121,15 @@ void NetworkClient::do_read_header() {
             if (!ec) {
                 uint32_t body_length;
                 std::memcpy(&body_length, read_msg_, sizeof(uint32_t));
+                if (body_length != GameMessage::kWireSize) {
+                    LOG_ERROR("[Client] Unexpected TCP body length: {}", body_length);
+                    tcp_socket.close(ec);
+                    return;
+                }
                 do_read_body(body_length);
             } else {
-                std::cerr << "[Client] TCP header read error: " << ec.message() << "\n";
-                tcp_socket.close();
+                if (ec != boost::asio::error::operation_aborted) LOG_ERROR("[Client] TCP header read error: {}", ec.message());
+                tcp_socket.close(ec);
             }
         });
 }
@@ -75,73 +139,213 @@ void NetworkClient::do_read_body(std::size_t body_length) {
         [this, body_length](boost::system::error_code ec, std::size_t /*length*/) {
             if (!ec) {
                 try {
-                    GameMessage msg = GameMessage::deserialize(read_msg_); // ✅ fixed
-                    {
-                        std::lock_guard<std::mutex> lock(incoming_mutex);
-                        incoming_tcp_messages.push_back(msg);
-                    }
+                    GameMessage msg = GameMessage::deserialize(read_msg_);
+                    if (msg.type == MessageType::HandshakeResult) handle_handshake_result(msg);
+                    dispatch(msg);
                 } catch (const std::exception& e) {
-                    std::cerr << "[Client] Failed to deserialize TCP message: " << e.what() << "\n";
+                    LOG_ERROR("[Client] Failed to deserialize TCP message: {}", e.what());
                 }
                 do_read_header();
             } else {
-                std::cerr << "[Client] TCP body read error: " << ec.message() << "\n";
-                tcp_socket.close();
+                if (ec != boost::asio::error::operation_aborted) LOG_ERROR("[Client] TCP body read error: {}", ec.message());
+                tcp_socket.close(ec);
             }
         });
 }
 
-void NetworkClient::do_write() {
-    if (write_msgs.empty()) return;
+void NetworkClient::handle_handshake_result(const GameMessage& msg) {
+    const auto r = msg.getData<HandshakeResultData>();
+    if (!r.success) {
+        LOG_ERROR("[Client] Handshake rejected: {}", std::string(r.message, strnlen(r.message, sizeof(r.message))));
+        return;
+    }
+    const bool first = udp_token_.load(std::memory_order_relaxed) == 0;
+    udp_slot_ = r.udp_slot;
+    udp_token_.store(r.udp_token, std::memory_order_release);
+    udp_conn_ = std::make_unique<ReliableEndpoint>(); // the server starts a fresh endpoint per handshake
+    if (first) start_udp();
+}
 
-    auto buffer = write_msgs.front().serialize();
-    uint32_t body_length = static_cast<uint32_t>(buffer.size());
-    std::vector<char> header(sizeof(uint32_t));
-    std::memcpy(header.data(), &body_length, sizeof(uint32_t));
+void NetworkClient::start_udp() {
+    // Same host the TCP connection reached, so no second name lookup and no
+    // chance of resolving to a different address
+    boost::system::error_code ec;
+    const auto server = tcp_socket.remote_endpoint(ec);
+    if (ec) {
+        LOG_ERROR("[Client] UDP setup failed, no TCP peer: {}", ec.message());
+        return;
+    }
+    server_udp_endpoint = udp::endpoint(server.address(), UDP_PORT);
 
-    std::vector<boost::asio::const_buffer> buffers;
-    buffers.push_back(boost::asio::buffer(header));
-    buffers.push_back(boost::asio::buffer(buffer));
+    udp_socket.open(server_udp_endpoint.protocol(), ec);
+    if (!ec) udp_socket.non_blocking(true, ec);
+    if (ec) {
+        LOG_ERROR("[Client] UDP socket setup failed: {}", ec.message());
+        return;
+    }
+    do_receive_udp();
+    schedule_udp_flush();
+}
 
-    boost::asio::async_write(tcp_socket, buffers,
-        [this](boost::system::error_code ec, std::size_t /*length*/) {
-            if (!ec) {
-                write_msgs.pop_front();
-                if (!write_msgs.empty()) {
-                    do_write();
-                }
-            } else {
-                std::cerr << "[Client] TCP write error: " << ec.message() << "\n";
-                tcp_socket.close();
-            }
-        });
+void NetworkClient::schedule_udp_flush() {
+    if (udp_conn_ && ++flushes_since_ping_ >= kPingEveryFlushes) {
+        flushes_since_ping_ = 0;
+        GameMessage ping{};
+        ping.type = MessageType::Ping;
+        ping.setData(PingData{ next_ping_id_++, steady_now_us() });
+        udp_conn_->send(Channel::Unreliable, ping);
+    }
+    flush_udp();
+    udp_flush_timer_.expires_after(kUdpFlushInterval);
+    udp_flush_timer_.async_wait([this](const boost::system::error_code& ec) {
+        if (!ec) schedule_udp_flush();
+    });
 }
 
-void NetworkClient::start_udp(const std::string& host) {
-    udp::resolver resolver(io_context);
-    udp::resolver::results_type endpoints = resolver.resolve(udp::v4(), host, std::to_string(UDP_PORT));
-    server_udp_endpoint = *endpoints.begin();
+void NetworkClient::flush_udp() {
+    if (!udp_conn_ || !udp_socket.is_open()) return;
 
-    udp_socket.open(udp::v4());
+    UdpHeader hdr{ udp_slot_, 0, udp_token_.load(std::memory_order_relaxed) };
+    std::memcpy(udp_send_buf_.data(), &hdr, sizeof(UdpHeader));
+    const std::size_t len = udp_conn_->write_packet(std::chrono::steady_clock::now(),
+                                                    udp_send_buf_.data() + sizeof(UdpHeader), kMaxPacketSize);
 
-    // Receive buffer size = sizeof(UDPMessage)
-    auto recv_buffer = std::make_shared<std::vector<char>>(sizeof(UDPMessage));
-    udp_socket.async_receive_from(boost::asio::buffer(*recv_buffer), server_udp_endpoint,
-        [this, recv_buffer, host](boost::system::error_code ec, std::size_t bytes_recvd) {
-            if (!ec && bytes_recvd == sizeof(UDPMessage)) {
-                try {
-                    UDPMessage msg;
-                    std::memcpy(&msg, recv_buffer->data(), sizeof(UDPMessage));
-                    {
-                        std::lock_guard<std::mutex> lock(incoming_mutex);
-                        incoming_udp_messages.push_back(msg);
-                    }
-                } catch (const std::exception& e) {
-                    std::cerr << "[Client] Failed to deserialize UDP message: " << e.what() << "\n";
-                }
-            } else if (ec) {
-                std::cerr << "[Client] UDP receive error: " << ec.message() << "\n";
+    boost::system::error_code ec;
+    udp_socket.send_to(boost::asio::buffer(udp_send_buf_.data(), sizeof(UdpHeader) + len), server_udp_endpoint, 0, ec);
+    if (ec == boost::asio::error::would_block || ec == boost::asio::error::try_again) {
+        LOG_WARN("[Client] UDP send buffer full, packet dropped");
+    } else if (ec) {
+        LOG_ERROR("[Client] UDP send error: {}", ec.message());
+    }
+}
+
+void NetworkClient::do_receive_udp() {
+    // Wait for readability rather than posting a receive, so no buffer is tied up in
+    // a pending operation and one wakeup can drain several datagrams.
+    udp_socket.async_wait(udp::socket::wait_read, [this](boost::system::error_code ec) {
+        if (ec) {
+            if (ec == boost::asio::error::operation_aborted || !udp_socket.is_open()) return;
+            udp_recv_stats_.errors.fetch_add(1, std::memory_order_relaxed);
+            LOG_ERROR("[Client] UDP wait error: {}", ec.message());
+        } else {
+            receive_udp_batch();
+        }
+        if (udp_socket.is_open()) do_receive_udp(); // continue listening
+    });
+}
+
+void NetworkClient::receive_udp_batch() {
+    std::size_t n = 0;
+    while (n < kUdpRecvBatch) {
+        UdpRecvSlot& slot = udp_recv_ring_[n];
+        boost::system::error_code ec;
+        slot.size = udp_socket.receive_from(boost::asio::buffer(slot.data), slot.sender, 0, ec);
+        if (ec == boost::asio::error::would_block || ec == boost::asio::error::try_again) break;
+        if (ec) {
+            // e.g. ICMP port unreachable while the server restarts; the next wakeup retries
+            udp_recv_stats_.errors.fetch_add(1, std::memory_order_relaxed);
+            LOG_ERROR("[Client] UDP receive error: {}", ec.message());
+            break;
+        }
+        ++n;
+    }
+
+    auto& st = udp_recv_stats_;
+    st.wakeups.fetch_add(1, std::memory_order_relaxed);
+    if (n > st.max_batch.load(std::memory_order_relaxed)) st.max_batch.store(n, std::memory_order_relaxed);
+
+    const auto now = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        const UdpRecvSlot& slot = udp_recv_ring_[i];
+        if (slot.sender != server_udp_endpoint) {
+            st.foreign.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (!udp_conn_) continue;
+        if (!udp_conn_->read_packet(slot.data.data(), slot.size, now, [this](const GameMessage& m) { dispatch(m); })) {
+            st.malformed.fetch_add(1, std::memory_order_relaxed);
+            LOG_WARN("[Client] Dropped malformed UDP packet ({} bytes)", slot.size);
+            continue;
+        }
+        st.datagrams.fetch_add(1, std::memory_order_relaxed);
+        st.bytes.fetch_add(slot.size, std::memory_order_relaxed);
+    }
+}
+
+NetworkClient::UdpRecvStats NetworkClient::udp_recv_stats() const {
+    const auto& st = udp_recv_stats_;
+    return { st.datagrams.load(std::memory_order_relaxed), st.bytes.load(std::memory_order_relaxed),
+             st.wakeups.load(std::memory_order_relaxed), st.max_batch.load(std::memory_order_relaxed),
+             st.foreign.load(std::memory_order_relaxed), st.malformed.load(std::memory_order_relaxed),
+             st.errors.load(std::memory_order_relaxed) };
+}
+
+void NetworkClient::dispatch(const GameMessage& msg) {
+    NetEvent ev{};
+    ev.type = msg.type;
+    switch (msg.type) {
+        case MessageType::Ping:
+        case MessageType::Pong:
+            handle_ping(msg); // answered and measured here, the frame never sees them
+            return;
+        case MessageType::PlayerState: {
+            // Only the populated entries, as individual events
+            int count = 0;
+            std::memcpy(&count, msg.data + offsetof(AllPlayersStateData, count), sizeof(int));
+            count = std::clamp(count, 0, MAX_PLAYERS);
+            std::memcpy(&ev.tick, msg.data + offsetof(AllPlayersStateData, tick), sizeof(uint32_t));
+            ev.received = std::chrono::steady_clock::now();
+            for (int i = 0; i < count; ++i) {
+                std::memcpy(ev.data, msg.data + offsetof(AllPlayersStateData, players) + i * sizeof(PlayerStateData),
+                            sizeof(PlayerStateData));
+                push_event(ev);
             }
-            start_udp(host); // continue listening
-        });
+            return;
+        }
+        case MessageType::PlayerJoin:
+        case MessageType::PlayerLeave:
+        case MessageType::ProjectileSpawn:
+        case MessageType::GameStateUpdate:
+        case MessageType::PlayerHit:
+        case MessageType::PlayerRespawn:
+        case MessageType::ChatMessage:
+            std::memcpy(ev.data, msg.data, std::min(sizeof(ev.data), message_payload_size(msg.type)));
+            push_event(ev);
+            return;
+        default:
+            return; // nothing the frame consumes (HandshakeResult is handled on the IO thread)
+    }
+}
+
+void NetworkClient::push_event(const NetEvent& ev) {
+    if (!events_.try_push(ev)) {
+        events_dropped_.fetch_add(1, std::memory_order_relaxed);
+        LOG_WARN("[Client] Event ring full, dropped {}", message_type_name(ev.type));
+        return;
+    }
+    events_pushed_.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t depth = events_.size();
+    if (depth > events_high_water_.load(std::memory_order_relaxed))
+        events_high_water_.store(depth, std::memory_order_relaxed);
+}
+
+void NetworkClient::handle_ping(const GameMessage& msg) {
+    if (msg.type == MessageType::Ping) {
+        // The server measuring us: echo at once instead of waiting for the next flush
+        const auto ping = msg.getData<PingData>();
+        GameMessage pong{};
+        pong.type = MessageType::Pong;
+        pong.setData(PongData{ ping.id, ping.sent_us, 0, 0 });
+        if (udp_conn_ && udp_conn_->send(Channel::Unreliable, pong)) flush_udp();
+        return;
+    }
+
+    const auto pong = msg.getData<PongData>();
+    const uint64_t now_us = steady_now_us();
+    if (pong.ping_sent_us == 0 || pong.ping_sent_us > now_us) return;
+    rtt_.add_sample((now_us - pong.ping_sent_us) / 1000.0);
+    rtt_ms_.store(rtt_.srtt_ms(), std::memory_order_relaxed);
+    rtt_jitter_ms_.store(rtt_.jitter_ms(), std::memory_order_relaxed);
+    rtt_valid_.store(true, std::memory_order_release);
+    server_clock_.on_pong(pong.ping_sent_us, now_us, pong.server_tick, pong.tick_age_us);
 }
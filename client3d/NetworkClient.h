@@ -2,13 +2,54 @@
 #pragma once
 #include <boost/asio.hpp>
 #include <thread>
-#include <deque>
-#include <mutex>
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
 #include "../shared/protocol.h"   // ✅ make sure this path is correct
+#include "../shared/clock_sync.h"
+#include "../shared/reliable_udp.h"
+#include "../shared/spsc_ring.h"
 
 using boost::asio::ip::tcp;
 using boost::asio::ip::udp;
 
+// Compact decoded form of a server message, handed from the IO thread to the frame.
+// A PlayerState snapshot arrives as one event per player (PlayerStateData payload)
+// stamped with the snapshot's server tick and arrival time; every other type keeps
+// its protocol payload.
+struct NetEvent {
+    MessageType type;
+    uint32_t tick;                                   // PlayerState only
+    std::chrono::steady_clock::time_point received;  // PlayerState only
+    char data[sizeof(ChatMessageData)]; // largest payload the frame consumes
+
+    template<typename T>
+    void setData(const T& d) {
+        static_assert(sizeof(T) <= sizeof(data), "Data too large for NetEvent::data");
+        std::memcpy(data, &d, sizeof(T));
+    }
+
+    template<typename T>
+    T getData() const {
+        T d;
+        std::memcpy(&d, data, sizeof(T));
+        return d;
+    }
+};
+
+// Simulation thread -> IO thread: the used bytes of an outgoing message. Everything the
+// client sends fits; larger payloads are rejected by send().
+struct OutgoingMessage {
+    MessageType type;
+    uint16_t size;
+    char data[std::max(sizeof(ChatMessageData), sizeof(PlayerInputFramesData))];
+};
+
 class NetworkClient {
 public:
     explicit NetworkClient(boost::asio::io_context& io);
@@ -16,33 +57,181 @@ public:
     void connect(const std::string& host, const std::string& port);
     void close();
 
-    void send_tcp(const GameMessage& msg);
-    void send_udp(const UDPMessage& msg);
+    // Simulation thread only. Copies the payload into the outgoing ring; the IO thread sends
+    // it over the UDP channel for msg.type once the handshake is done, else TCP.
+    // Returns false if the payload is too large or the ring is full.
+    bool send(const GameMessage& msg);
 
     void set_id(uint32_t id) { my_id = id; }
     uint32_t get_id() const { return my_id; }
 
-    // Queues for incoming messages
-    std::deque<GameMessage> incoming_tcp_messages;
-    std::deque<UDPMessage> incoming_udp_messages;
-    std::mutex incoming_mutex;
+    // True once the server accepted our Handshake and issued a UDP slot/token
+    bool udp_ready() const { return udp_token_.load(std::memory_order_acquire) != 0; }
+
+    struct UdpRecvStats {
+        uint64_t datagrams;    // accepted from the server endpoint
+        uint64_t bytes;
+        uint64_t wakeups;      // readiness notifications; datagrams / wakeups is the batch size
+        uint64_t max_batch;
+        uint64_t foreign;      // dropped: not from the server endpoint
+        uint64_t malformed;    // dropped: rejected by the reliability layer
+        uint64_t errors;       // socket receive errors
+    };
+    UdpRecvStats udp_recv_stats() const;
+
+    // From our Pings to the server (every kPingInterval once UDP is up)
+    struct Latency {
+        bool valid;            // at least one Pong received
+        double rtt_ms;         // smoothed
+        double jitter_ms;
+    };
+    Latency latency() const {
+        return { rtt_valid_.load(std::memory_order_acquire), rtt_ms_.load(std::memory_order_relaxed),
+                 rtt_jitter_ms_.load(std::memory_order_relaxed) };
+    }
+    // Estimated current server tick (fractional); valid once server_clock_synced()
+    bool server_clock_synced() const { return server_clock_.synced(); }
+    double estimated_server_tick() const { return server_clock_.server_tick(steady_now_us()); }
+
+    // Simulation thread only: next event from either transport, in arrival order
+    bool poll_event(NetEvent& out) { return events_.try_pop(out); }
+
+    // About a second of 16-player snapshots at the 60 Hz tick
+    static constexpr std::size_t kEventCapacity = 1024;
+
+    struct EventStats {
+        uint64_t pushed;
+        uint64_t dropped;     // ring full: the frame fell more than kEventCapacity events behind
+        std::size_t high_water;
+    };
+    EventStats event_stats() const {
+        return { events_pushed_.load(std::memory_order_relaxed), events_dropped_.load(std::memory_order_relaxed),
+                 events_high_water_.load(std::memory_order_relaxed) };
+    }
 
 private:
     void do_read_header();
     void do_read_body(std::size_t body_length);
-    void do_write();
+    // IO thread: send path
+    void drain_outgoing();
+    void send_now(MessageType type, const char* payload, std::size_t size);
+    void queue_tcp(MessageType type, const char* payload, std::size_t size);
+    void start_tcp_write();
+
+    // IO thread: decode msg into events for the frame
+    void dispatch(const GameMessage& msg);
+    void push_event(const NetEvent& ev);
 
-    // UDP
-    void start_udp(const std::string& host);
+    // Handshake / UDP
+    void handle_handshake_result(const GameMessage& msg);
+    void start_udp();
+    void do_receive_udp();
+    void receive_udp_batch();
+    void flush_udp();
+    void schedule_udp_flush();
+    void handle_ping(const GameMessage& msg);
 
     boost::asio::io_context& io_context;
     tcp::socket tcp_socket;
     udp::socket udp_socket;
     udp::endpoint server_udp_endpoint;
+    boost::asio::steady_timer udp_flush_timer_;
+
+    // Outgoing ring, single producer (simulation thread), single consumer (IO thread). A drain
+    // is posted only when none is pending, so a burst of sends costs one handler.
+    SpscRing<OutgoingMessage, 256> outgoing_;
+    std::atomic<bool> drain_posted_{false};
+
+    // Memory for that one outstanding drain handler. The simulation thread has no Asio
+    // handler cache, so a plain post would allocate on every send.
+    class HandlerMemory {
+    public:
+        void* allocate(std::size_t size) {
+            if (size <= sizeof(storage_) && !in_use_.exchange(true, std::memory_order_acquire)) return storage_;
+            return ::operator new(size);
+        }
+        void deallocate(void* p) {
+            if (p == storage_) in_use_.store(false, std::memory_order_release);
+            else ::operator delete(p);
+        }
+    private:
+        alignas(std::max_align_t) unsigned char storage_[256];
+        std::atomic<bool> in_use_{false};
+    };
+
+    template <typename T>
+    struct HandlerAllocator {
+        using value_type = T;
+        explicit HandlerAllocator(HandlerMemory& m) : mem(&m) {}
+        template <typename U> HandlerAllocator(const HandlerAllocator<U>& o) : mem(o.mem) {}
+        T* allocate(std::size_t n) { return static_cast<T*>(mem->allocate(sizeof(T) * n)); }
+        void deallocate(T* p, std::size_t) { mem->deallocate(p); }
+        bool operator==(const HandlerAllocator& o) const { return mem == o.mem; }
+        bool operator!=(const HandlerAllocator& o) const { return mem != o.mem; }
+        HandlerMemory* mem;
+    };
+
+    struct DrainHandler {
+        NetworkClient* self;
+        using allocator_type = HandlerAllocator<DrainHandler>;
+        allocator_type get_allocator() const noexcept { return allocator_type(self->drain_memory_); }
+        void operator()() const { self->drain_outgoing(); }
+    };
+    HandlerMemory drain_memory_;
+
+    // TCP frames are appended to tcp_pending_ while tcp_inflight_ is being written, and
+    // the two swap when the write completes: everything queued meanwhile goes out in
+    // one write, and both buffers keep their capacity, so steady state never allocates.
+    std::vector<char> tcp_pending_;
+    std::vector<char> tcp_inflight_;
+    bool tcp_write_in_progress_ = false;
 
-    std::deque<GameMessage> write_msgs;
     enum { header_length = sizeof(uint32_t) };
-    char read_msg_[2048];  // ✅ increased from 512 → 2048 for safety
+    char read_msg_[GameMessage::kWireSize];
+
+    // Issued by HandshakeResult (written on the IO thread)
+    uint16_t udp_slot_ = 0;
+    std::atomic<uint32_t> udp_token_{0};
+
+    // IO thread only. A packet goes out every flush interval even when empty: it carries
+    // our acks and binds our endpoint on the server.
+    std::unique_ptr<ReliableEndpoint> udp_conn_;
+
+    // Receive path: the socket is resolved and opened once in start_udp. Each wakeup
+    // reads every queued datagram (up to kUdpRecvBatch) into a fixed ring of buffers
+    // with non-blocking receives, then feeds the batch to udp_conn_.
+    static constexpr std::size_t kUdpRecvBatch = 16;
+    struct UdpRecvSlot {
+        std::array<char, 1536> data;
+        std::size_t size;
+        udp::endpoint sender;
+    };
+    std::array<UdpRecvSlot, kUdpRecvBatch> udp_recv_ring_{};
+    struct {
+        std::atomic<uint64_t> datagrams{0}, bytes{0}, wakeups{0}, max_batch{0}, foreign{0}, malformed{0}, errors{0};
+    } udp_recv_stats_;
+    static constexpr std::chrono::microseconds kUdpFlushInterval{SERVER_TICK_US}; // one packet per server tick
+
+    // Ping/Pong (IO thread); results published through the atomics for latency()
+    static constexpr int kPingEveryFlushes = 15; // ~250 ms
+    int flushes_since_ping_ = 0;
+    uint32_t next_ping_id_ = 1;
+    RttEstimator rtt_;
+    std::atomic<bool> rtt_valid_{false};
+    std::atomic<double> rtt_ms_{0.0};
+    std::atomic<double> rtt_jitter_ms_{0.0};
+    ServerClockEstimator server_clock_{ static_cast<double>(SERVER_TICK_US) };
+
+    // Datagrams go out with a synchronous send on the non-blocking socket, so one
+    // buffer suffices. A send that would block is dropped; reliable messages in it are
+    // resent by udp_conn_ like any lost packet.
+    std::array<char, sizeof(UdpHeader) + kMaxPacketSize> udp_send_buf_{};
+
+    // Single producer (IO thread), single consumer (simulation thread)
+    SpscRing<NetEvent, kEventCapacity> events_;
+    std::atomic<uint64_t> events_pushed_{0};
+    std::atomic<uint64_t> events_dropped_{0};
+    std::atomic<std::size_t> events_high_water_{0};
 
     uint32_t my_id = 0;
 };
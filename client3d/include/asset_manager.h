@@ -0,0 +1,214 @@
+#pragma once
+
+// Background asset loading.
+//
+// Assets are requested by path and shared: asking twice for the same path returns the
+// same object. Worker threads do the file IO and decoding (mesh cache or OBJ cook,
+// stb_image, WAV decode) and hand the finished CPU data to the render thread, which
+// uploads it in small steps from pump() within a per-frame time budget, so the window
+// runs from the first frame and a large model never stalls one. Callers poll ready().
+//
+// The manager's cache holds one reference to every asset; collect() drops those
+// nobody else references any more.
+
+#include <SFML/Audio.hpp>
+
+#include "model.h"
+#include "log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class Asset {
+public:
+    explicit Asset(std::string path) : path_(std::move(path)) {}
+    virtual ~Asset() = default;
+
+    const std::string& path() const { return path_; }
+    bool ready() const { return state_.load(std::memory_order_acquire) == State::Ready; }
+    bool failed() const { return state_.load(std::memory_order_acquire) == State::Failed; }
+
+protected:
+    friend class AssetManager;
+    enum class State { Loading, Uploading, Ready, Failed };
+
+    // Worker thread: all CPU work; throws on failure
+    virtual void load() = 0;
+    // Render thread: one bounded piece of GL/AL work; true once everything is uploaded
+    virtual bool uploadStep() = 0;
+
+    std::atomic<State> state_{State::Loading};
+
+private:
+    std::string path_;
+};
+
+class ModelAsset : public Asset {
+public:
+    using Asset::Asset;
+
+    Model model;
+
+protected:
+    void load() override {
+        model.directory = model_directory(path());
+        source_ = std::make_unique<ModelSource>(path(), kDefaultVertexFormat);
+    }
+    bool uploadStep() override {
+        if (model.uploadNext(source_->model())) return false;
+        source_.reset(); // unmaps the cache / frees the cooked data
+        return true;
+    }
+
+private:
+    std::unique_ptr<ModelSource> source_;
+};
+
+class SoundAsset : public Asset {
+public:
+    using Asset::Asset;
+
+    sf::SoundBuffer buffer;
+
+protected:
+    void load() override {
+        sf::InputSoundFile file;
+        if (!file.openFromFile(path())) throw std::runtime_error("could not open " + path());
+        samples_.resize(static_cast<std::size_t>(file.getSampleCount()));
+        samples_.resize(static_cast<std::size_t>(file.read(samples_.data(), samples_.size())));
+        channels_ = file.getChannelCount();
+        rate_ = file.getSampleRate();
+    }
+    bool uploadStep() override {
+        if (!buffer.loadFromSamples(samples_.data(), samples_.size(), channels_, rate_))
+            LOG_ERROR("[Assets] Could not create sound buffer for {}", path());
+        samples_ = {};
+        return true;
+    }
+
+private:
+    std::vector<sf::Int16> samples_;
+    unsigned channels_ = 0;
+    unsigned rate_ = 0;
+};
+
+class AssetManager {
+public:
+    explicit AssetManager(unsigned workers = 2) {
+        for (unsigned i = 0; i < std::max(workers, 1u); i++)
+            workers_.emplace_back([this] { workerLoop(); });
+    }
+
+    ~AssetManager() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_) worker.join();
+    }
+
+    AssetManager(const AssetManager&) = delete;
+    AssetManager& operator=(const AssetManager&) = delete;
+
+    std::shared_ptr<ModelAsset> model(const std::string& path) { return request<ModelAsset>(path); }
+    std::shared_ptr<SoundAsset> sound(const std::string& path) { return request<SoundAsset>(path); }
+
+    // Render thread, once per frame: uploads loaded assets until budget is spent (always
+    // at least one step, so loading progresses however tight the budget)
+    void pump(std::chrono::microseconds budget) {
+        const auto deadline = std::chrono::steady_clock::now() + budget;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& asset : loaded_) uploading_.push_back(std::move(asset));
+            loaded_.clear();
+        }
+        while (!uploading_.empty()) {
+            const std::shared_ptr<Asset>& asset = uploading_.front();
+            if (asset->uploadStep()) {
+                asset->state_.store(Asset::State::Ready, std::memory_order_release);
+                uploading_.pop_front();
+            }
+            if (std::chrono::steady_clock::now() >= deadline) break;
+        }
+    }
+
+    // Render thread: forgets finished assets only the cache still references
+    void collect() {
+        for (auto it = cache_.begin(); it != cache_.end(); ) {
+            const bool settled = it->second->ready() || it->second->failed();
+            if (settled && it->second.use_count() == 1) it = cache_.erase(it);
+            else ++it;
+        }
+    }
+
+    // Assets requested but not yet ready
+    std::size_t pending() const {
+        return static_cast<std::size_t>(std::count_if(cache_.begin(), cache_.end(), [](const auto& entry) {
+            return !entry.second->ready() && !entry.second->failed();
+        }));
+    }
+
+private:
+    // Render thread
+    template <typename T>
+    std::shared_ptr<T> request(const std::string& path) {
+        auto found = cache_.find(path);
+        if (found != cache_.end()) {
+            if (auto asset = std::dynamic_pointer_cast<T>(found->second)) return asset;
+            LOG_ERROR("[Assets] {} requested as two different asset types", path);
+            return nullptr;
+        }
+        auto asset = std::make_shared<T>(path);
+        cache_.emplace(path, asset);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.push_back(asset);
+        }
+        wake_.notify_one();
+        return asset;
+    }
+
+    void workerLoop() {
+        for (;;) {
+            std::shared_ptr<Asset> asset;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+                if (stopping_) return;
+                asset = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            try {
+                asset->load();
+            } catch (const std::exception& e) {
+                LOG_ERROR("[Assets] Failed to load {}: {}", asset->path(), e.what());
+                asset->state_.store(Asset::State::Failed, std::memory_order_release);
+                continue;
+            }
+            asset->state_.store(Asset::State::Uploading, std::memory_order_release);
+            std::lock_guard<std::mutex> lock(mutex_);
+            loaded_.push_back(std::move(asset));
+        }
+    }
+
+    std::unordered_map<std::string, std::shared_ptr<Asset>> cache_; // render thread only
+    std::deque<std::shared_ptr<Asset>> uploading_;                   // render thread only
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::deque<std::shared_ptr<Asset>> jobs_;   // requested, waiting for a worker
+    std::deque<std::shared_ptr<Asset>> loaded_; // loaded, waiting for pump()
+    std::vector<std::thread> workers_;
+};
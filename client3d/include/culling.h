@@ -0,0 +1,191 @@
+#pragma once
+
+// View frustum culling.
+//
+// Frustum holds the six planes of a view-projection matrix in structure-of-arrays
+// form so one box is tested against four planes per SSE instruction. SceneBvh is a
+// bounding volume hierarchy over the static renderables, built once; cull() walks it,
+// dropping subtrees outside the frustum and accepting whole subtrees inside it without
+// testing their contents.
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CULLING_SSE 1
+#include <emmintrin.h>
+#endif
+
+struct AABB { glm::vec3 min; glm::vec3 max; };
+
+inline AABB merge(const AABB& a, const AABB& b) {
+    return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+}
+
+// World bounds of a box under an affine transform (Arvo)
+inline AABB transform_aabb(const AABB& box, const glm::mat4& m) {
+    AABB out{ glm::vec3(m[3]), glm::vec3(m[3]) };
+    for (int col = 0; col < 3; col++) {
+        for (int row = 0; row < 3; row++) {
+            const float a = m[col][row] * box.min[col];
+            const float b = m[col][row] * box.max[col];
+            out.min[row] += std::min(a, b);
+            out.max[row] += std::max(a, b);
+        }
+    }
+    return out;
+}
+
+enum class Containment { Outside, Intersects, Inside };
+
+class Frustum {
+public:
+    // Planes of clip space -w <= x,y,z <= w (Gribb/Hartmann), normals pointing inwards
+    explicit Frustum(const glm::mat4& view_projection) {
+        const glm::mat4& m = view_projection;
+        auto row = [&m](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+        const glm::vec4 planes[6] = {
+            row(3) + row(0), row(3) - row(0), // left, right
+            row(3) + row(1), row(3) - row(1), // bottom, top
+            row(3) + row(2), row(3) - row(2), // near, far
+        };
+        for (int i = 0; i < kLanes; i++) {
+            // the two padding lanes are 0x + 0y + 0z + 1 >= 0: always inside
+            glm::vec4 p = i < 6 ? planes[i] * (1.0f / glm::length(glm::vec3(planes[i]))) : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+            x_[i] = p.x; y_[i] = p.y; z_[i] = p.z; w_[i] = p.w;
+        }
+    }
+
+    Containment classify(const AABB& box) const {
+        bool inside = true;
+#ifdef CULLING_SSE
+        const __m128 min_x = _mm_set1_ps(box.min.x), max_x = _mm_set1_ps(box.max.x);
+        const __m128 min_y = _mm_set1_ps(box.min.y), max_y = _mm_set1_ps(box.max.y);
+        const __m128 min_z = _mm_set1_ps(box.min.z), max_z = _mm_set1_ps(box.max.z);
+        const __m128 zero = _mm_setzero_ps();
+        for (int i = 0; i < kLanes; i += 4) {
+            const __m128 nx = _mm_load_ps(x_ + i), ny = _mm_load_ps(y_ + i), nz = _mm_load_ps(z_ + i);
+            const __m128 ax = _mm_mul_ps(nx, min_x), bx = _mm_mul_ps(nx, max_x);
+            const __m128 ay = _mm_mul_ps(ny, min_y), by = _mm_mul_ps(ny, max_y);
+            const __m128 az = _mm_mul_ps(nz, min_z), bz = _mm_mul_ps(nz, max_z);
+            const __m128 w = _mm_load_ps(w_ + i);
+            // signed distance of the corner furthest along each normal, and of the nearest one
+            const __m128 far_d = _mm_add_ps(_mm_add_ps(_mm_max_ps(ax, bx), _mm_max_ps(ay, by)), _mm_add_ps(_mm_max_ps(az, bz), w));
+            const __m128 near_d = _mm_add_ps(_mm_add_ps(_mm_min_ps(ax, bx), _mm_min_ps(ay, by)), _mm_add_ps(_mm_min_ps(az, bz), w));
+            if (_mm_movemask_ps(_mm_cmplt_ps(far_d, zero))) return Containment::Outside;
+            if (_mm_movemask_ps(_mm_cmplt_ps(near_d, zero))) inside = false;
+        }
+#else
+        for (int i = 0; i < 6; i++) {
+            const float ax = x_[i] * box.min.x, bx = x_[i] * box.max.x;
+            const float ay = y_[i] * box.min.y, by = y_[i] * box.max.y;
+            const float az = z_[i] * box.min.z, bz = z_[i] * box.max.z;
+            if (std::max(ax, bx) + std::max(ay, by) + std::max(az, bz) + w_[i] < 0.0f) return Containment::Outside;
+            if (std::min(ax, bx) + std::min(ay, by) + std::min(az, bz) + w_[i] < 0.0f) inside = false;
+        }
+#endif
+        return inside ? Containment::Inside : Containment::Intersects;
+    }
+
+    bool intersects(const AABB& box) const { return classify(box) != Containment::Outside; }
+
+private:
+    static constexpr int kLanes = 8; // 6 planes padded to two SSE registers
+    alignas(16) float x_[kLanes];
+    alignas(16) float y_[kLanes];
+    alignas(16) float z_[kLanes];
+    alignas(16) float w_[kLanes];
+};
+
+struct CullStats {
+    uint32_t objects = 0;       // candidates
+    uint32_t visible = 0;
+    uint32_t nodes_visited = 0; // BVH nodes whose box was tested
+};
+
+// Static BVH over (bounds, id) items. Nodes are stored depth first: a node's left child
+// follows it, and the items under any node are a contiguous range, so a subtree fully
+// inside the frustum is accepted as one range.
+class SceneBvh {
+public:
+    void add(const AABB& bounds, uint32_t id) { items_.push_back({ bounds, id }); }
+
+    void build() {
+        nodes_.clear();
+        if (!items_.empty()) buildNode(0, static_cast<uint32_t>(items_.size()));
+    }
+
+    std::size_t size() const { return items_.size(); }
+
+    // Appends the ids of items that may be visible to `visible`
+    void cull(const Frustum& frustum, std::vector<uint32_t>& visible, CullStats& stats) const {
+        stats.objects += static_cast<uint32_t>(items_.size());
+        if (nodes_.empty()) return;
+        uint32_t stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& node = nodes_[stack[--top]];
+            stats.nodes_visited++;
+            const Containment c = frustum.classify(node.bounds);
+            if (c == Containment::Outside) continue;
+            if (c == Containment::Inside || node.leaf) {
+                for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                    // leaves partly inside still test each item; inside subtrees need not
+                    if (c == Containment::Inside || node.count == 1 || frustum.intersects(items_[i].bounds)) {
+                        visible.push_back(items_[i].id);
+                        stats.visible++;
+                    }
+                }
+                continue;
+            }
+            stack[top++] = node.right;
+            stack[top++] = static_cast<uint32_t>(&node - nodes_.data()) + 1;
+        }
+    }
+
+private:
+    struct Item {
+        AABB bounds;
+        uint32_t id;
+    };
+    struct Node {
+        AABB bounds;
+        uint32_t first; // items [first, first + count) are under this node
+        uint32_t count;
+        uint32_t right; // interior nodes: index of the right child (left is the next node)
+        bool leaf;
+    };
+    static constexpr uint32_t kLeafSize = 4;
+
+    // Median split along the longest axis of the centroids
+    void buildNode(uint32_t first, uint32_t count) {
+        const uint32_t index = static_cast<uint32_t>(nodes_.size());
+        nodes_.push_back({});
+        AABB bounds = items_[first].bounds;
+        AABB centroids{ center(items_[first]), center(items_[first]) };
+        for (uint32_t i = first + 1; i < first + count; i++) {
+            bounds = merge(bounds, items_[i].bounds);
+            centroids = merge(centroids, { center(items_[i]), center(items_[i]) });
+        }
+        nodes_[index] = { bounds, first, count, 0, count <= kLeafSize };
+        if (count <= kLeafSize) return;
+
+        const glm::vec3 extent = centroids.max - centroids.min;
+        const int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        const uint32_t half = count / 2;
+        std::nth_element(items_.begin() + first, items_.begin() + first + half, items_.begin() + first + count,
+                         [axis](const Item& a, const Item& b) { return center(a)[axis] < center(b)[axis]; });
+        buildNode(first, half);
+        nodes_[index].right = static_cast<uint32_t>(nodes_.size());
+        buildNode(first + half, count - half);
+    }
+
+    static glm::vec3 center(const Item& item) { return (item.bounds.min + item.bounds.max) * 0.5f; }
+
+    std::vector<Item> items_;
+    std::vector<Node> nodes_;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// Per-frame uniforms shared by every shader through the std140 block
+//
+//     layout (std140) uniform Frame { ... };
+//
+// declared identically in the shaders. The buffer stays bound to kFrameUniformBinding;
+// each frame is one update() instead of setting the same matrices on every program.
+constexpr GLuint kFrameUniformBinding = 0;
+constexpr const char* kFrameUniformBlock = "Frame";
+
+// Mirrors the GLSL block member for member; vec3s are padded to vec4 as std140 would
+struct FrameUniforms {
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::vec4 viewPos;
+    glm::vec4 lightPosition;
+    glm::vec4 lightAmbient;
+    glm::vec4 lightDiffuse;
+    glm::vec4 lightSpecular;
+};
+static_assert(sizeof(FrameUniforms) == 2 * 64 + 5 * 16, "FrameUniforms must match the std140 Frame block");
+
+class FrameUniformBuffer {
+public:
+    FrameUniformBuffer() {
+        glGenBuffers(1, &ubo_);
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo_);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, kFrameUniformBinding, ubo_);
+    }
+    ~FrameUniformBuffer() { glDeleteBuffers(1, &ubo_); }
+    FrameUniformBuffer(const FrameUniformBuffer&) = delete;
+    FrameUniformBuffer& operator=(const FrameUniformBuffer&) = delete;
+
+    void update(const FrameUniforms& frame) {
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo_);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frame);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+private:
+    GLuint ubo_ = 0;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// Per-instance attributes shared by the instanced shaders: the model matrix in
+// locations 3-6 (one column each) and a color in location 7.
+struct InstanceData {
+    glm::mat4 model;
+    glm::vec4 color;
+};
+
+constexpr GLuint kInstanceModelLocation = 3;
+constexpr GLuint kInstanceColorLocation = 7;
+
+// The instances of one mesh type. The CPU side is refilled (usually every frame), then
+// upload() streams it into the instance buffer (orphaned, so the driver never waits
+// on last frame's draws) and the mesh is drawn once with glDraw*Instanced.
+class InstanceBatch {
+public:
+    InstanceBatch() { glGenBuffers(1, &vbo_); }
+    ~InstanceBatch() { glDeleteBuffers(1, &vbo_); }
+    InstanceBatch(const InstanceBatch&) = delete;
+    InstanceBatch& operator=(const InstanceBatch&) = delete;
+
+    // Sources the per-instance attributes of vao from this batch. A VAO can take
+    // instances from one batch only; meshes drawn from several batches need one VAO each.
+    void attach(GLuint vao) const {
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+        for (GLuint i = 0; i < 4; ++i) {
+            const GLuint loc = kInstanceModelLocation + i;
+            glEnableVertexAttribArray(loc);
+            glVertexAttribPointer(loc, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                                  (void*)(offsetof(InstanceData, model) + i * sizeof(glm::vec4)));
+            glVertexAttribDivisor(loc, 1);
+        }
+        glEnableVertexAttribArray(kInstanceColorLocation);
+        glVertexAttribPointer(kInstanceColorLocation, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                              (void*)offsetof(InstanceData, color));
+        glVertexAttribDivisor(kInstanceColorLocation, 1);
+        glBindVertexArray(0);
+    }
+
+    void clear() { instances_.clear(); }
+    void add(const glm::mat4& model, const glm::vec4& color = glm::vec4(1.0f)) { instances_.push_back({ model, color }); }
+    GLsizei count() const { return static_cast<GLsizei>(instances_.size()); }
+
+    void upload() {
+        if (instances_.empty()) return;
+        const std::size_t bytes = instances_.size() * sizeof(InstanceData);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+        while (capacity_ < bytes) capacity_ = capacity_ ? capacity_ * 2 : 64 * sizeof(InstanceData);
+        glBufferData(GL_ARRAY_BUFFER, capacity_, nullptr, GL_STREAM_DRAW); // orphan
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, instances_.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+private:
+    GLuint vbo_ = 0;
+    std::size_t capacity_ = 0;
+    std::vector<InstanceData> instances_;
+};
+
+// For a non-instanced draw with an instanced shader: with the instance arrays disabled
+// in the bound VAO, the shader reads these constant values instead.
+inline void set_constant_instance(const glm::mat4& model, const glm::vec4& color) {
+    for (GLuint i = 0; i < 4; ++i)
+        glVertexAttrib4fv(kInstanceModelLocation + i, &model[i][0]);
+    glVertexAttrib4fv(kInstanceColorLocation, &color[0]);
+}
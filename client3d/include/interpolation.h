@@ -0,0 +1,143 @@
+#pragma once
+
+// Snapshot interpolation for remote players.
+//
+// Every PlayerState snapshot carries the server tick it was taken on. SnapshotClock
+// maps ticks to local time from their arrival times and tracks how late they arrive;
+// remote players are drawn at render_tick(), the estimated current server tick minus
+// an interpolation delay, between the two buffered snapshots around it. The delay is
+// one tick plus a jitter margin, so it stays close to one tick on a clean link and
+// only grows as far as late packets require. When the render tick runs past the newest
+// snapshot (late or lost packets) motion is extrapolated for at most
+// kMaxExtrapolationTicks and then held.
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+#include "../../shared/protocol.h"
+
+constexpr double kServerTickSeconds = SERVER_TICK_US / 1e6;
+constexpr double kMinDelayTicks = 1.0;
+constexpr double kMaxDelayTicks = 8.0;
+constexpr double kMaxExtrapolationTicks = 6.0;  // ~100 ms, then the player stops
+
+class SnapshotClock {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Call for every snapshot; repeats of the newest tick are ignored
+    void on_snapshot(uint32_t tick, Clock::time_point received) {
+        if (has_tick_ && tick == newest_tick_) return;
+        // Local time of server tick 0 as implied by this packet
+        const double sample = seconds(received) - tick * kServerTickSeconds;
+
+        if (!has_tick_ || tick + 64 < newest_tick_ || std::abs(sample - offset_) > 1.0) {
+            // First snapshot, or the server restarted / our clock jumped
+            offset_ = sample;
+            jitter_ = 0.0;
+            delay_ticks_ = kMinDelayTicks;
+            newest_tick_ = tick;
+            has_tick_ = true;
+            return;
+        }
+
+        // Early packets pull the offset down fast and late ones raise it slowly, so it
+        // follows the least delayed path and lateness shows up as jitter instead
+        const double diff = sample - offset_;
+        offset_ += diff * (diff < 0.0 ? 0.5 : 0.02);
+        jitter_ += (std::abs(diff) - jitter_) * 0.1;
+        newest_tick_ = std::max(newest_tick_, tick);
+
+        // Grow the delay quickly when packets get late, give it back slowly
+        const double target = std::clamp(kMinDelayTicks + 2.0 * jitter_ / kServerTickSeconds,
+                                         kMinDelayTicks, kMaxDelayTicks);
+        delay_ticks_ += (target - delay_ticks_) * (target > delay_ticks_ ? 0.1 : 0.01);
+    }
+
+    bool ready() const { return has_tick_; }
+
+    // Fractional server tick remote players should be drawn at
+    double render_tick(Clock::time_point now) const {
+        return (seconds(now) - offset_) / kServerTickSeconds - delay_ticks_;
+    }
+
+    double delay_ms() const { return delay_ticks_ * kServerTickSeconds * 1000.0; }
+    double jitter_ms() const { return jitter_ * 1000.0; }
+
+private:
+    static double seconds(Clock::time_point t) {
+        return std::chrono::duration<double>(t.time_since_epoch()).count();
+    }
+
+    bool has_tick_ = false;
+    uint32_t newest_tick_ = 0;
+    double offset_ = 0.0;      // seconds
+    double jitter_ = 0.0;      // seconds, smoothed lateness
+    double delay_ticks_ = kMinDelayTicks;
+};
+
+// The last few snapshots of one entity, oldest first
+class SnapshotBuffer {
+public:
+    void push(uint32_t tick, const glm::vec3& position, const glm::quat& rotation) {
+        if (count_ && tick <= at(count_ - 1).tick) return; // late or duplicate: newer data already in
+        slots_[head_] = { tick, position, rotation };
+        head_ = (head_ + 1) % kCapacity;
+        count_ = std::min(count_ + 1, kCapacity);
+    }
+
+    void clear() { count_ = 0; }
+
+    // Position and rotation at a fractional server tick; false if nothing is buffered
+    bool sample(double tick, glm::vec3& position, glm::quat& rotation) const {
+        if (count_ == 0) return false;
+
+        const Snapshot& newest = at(count_ - 1);
+        if (tick >= newest.tick) {
+            position = newest.position;
+            rotation = newest.rotation;
+            if (count_ >= 2) {
+                const Snapshot& prev = at(count_ - 2);
+                const float ahead = static_cast<float>(std::min(tick - newest.tick, kMaxExtrapolationTicks));
+                const glm::vec3 velocity = (newest.position - prev.position) / static_cast<float>(newest.tick - prev.tick);
+                position += velocity * ahead;
+            }
+            return true;
+        }
+
+        for (int i = count_ - 2; i >= 0; --i) {
+            const Snapshot& a = at(i);
+            if (a.tick > tick) continue;
+            const Snapshot& b = at(i + 1);
+            const float t = static_cast<float>((tick - a.tick) / (b.tick - a.tick));
+            position = glm::mix(a.position, b.position, t);
+            rotation = glm::slerp(a.rotation, b.rotation, t);
+            return true;
+        }
+
+        // Older than anything buffered
+        position = at(0).position;
+        rotation = at(0).rotation;
+        return true;
+    }
+
+private:
+    struct Snapshot {
+        uint32_t tick;
+        glm::vec3 position;
+        glm::quat rotation;
+    };
+    static constexpr int kCapacity = 32; // ~0.5 s at the server tick rate
+
+    const Snapshot& at(int i) const { return slots_[(head_ + kCapacity - count_ + i) % kCapacity]; }
+
+    std::array<Snapshot, kCapacity> slots_{};
+    int head_ = 0;
+    int count_ = 0;
+};
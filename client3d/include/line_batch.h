@@ -0,0 +1,113 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "instancing.h"
+
+// Colored line segments (tracers, debug lines) streamed into one VBO and drawn with a
+// single glDrawArrays per frame. Use with an instanced shader: color is a vertex
+// attribute in kInstanceColorLocation and the model matrix comes from
+// set_constant_instance().
+//
+// GL 3.3 has no persistently mapped buffers, so the VBO is split into kFrames regions
+// used round-robin. begin() maps the frame's region unsynchronized, add() writes
+// straight into it and end() unmaps it; the caller then draws vertex_count() vertices
+// from first_vertex() with vao() (usually through the RenderQueue). The next begin()
+// fences the region behind that draw, and the fence is waited on only when the region
+// comes round again, by which time the GPU is long done.
+class LineBatch {
+public:
+    static constexpr int kFrames = 3;
+
+    explicit LineBatch(std::size_t max_segments = 4096) : max_vertices_(max_segments * 2) {
+        glGenVertexArrays(1, &vao_);
+        glGenBuffers(1, &vbo_);
+        glBindVertexArray(vao_);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+        glBufferData(GL_ARRAY_BUFFER, kFrames * region_bytes(), nullptr, GL_STREAM_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+        glEnableVertexAttribArray(kInstanceColorLocation);
+        glVertexAttribPointer(kInstanceColorLocation, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    ~LineBatch() {
+        for (GLsync& fence : fences_)
+            if (fence) glDeleteSync(fence);
+        glDeleteBuffers(1, &vbo_);
+        glDeleteVertexArrays(1, &vao_);
+    }
+    LineBatch(const LineBatch&) = delete;
+    LineBatch& operator=(const LineBatch&) = delete;
+
+    void begin() {
+        if (fence_pending_) {
+            fences_[(region_ + kFrames - 1) % kFrames] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            fence_pending_ = false;
+        }
+        wait_region(region_);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+        mapped_ = static_cast<Vertex*>(glMapBufferRange(GL_ARRAY_BUFFER, region_ * region_bytes(), region_bytes(),
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        count_ = 0;
+    }
+
+    // Segments past the capacity are dropped for the frame and counted
+    void add(const glm::vec3& a, const glm::vec3& b, const glm::vec4& color) {
+        if (!mapped_ || count_ + 2 > max_vertices_) { ++dropped_; return; }
+        mapped_[count_++] = { a, color };
+        mapped_[count_++] = { b, color };
+    }
+
+    void end() {
+        if (!mapped_) return;
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+        if (glUnmapBuffer(GL_ARRAY_BUFFER) != GL_TRUE) count_ = 0; // contents lost, skip the frame
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        mapped_ = nullptr;
+        first_ = region_ * max_vertices_;
+        fence_pending_ = true;
+        region_ = (region_ + 1) % kFrames;
+    }
+
+    // The frame's draw, valid after end(): GL_LINES over vertex_count() vertices
+    GLuint vao() const { return vao_; }
+    GLint first_vertex() const { return static_cast<GLint>(first_); }
+    GLsizei vertex_count() const { return static_cast<GLsizei>(count_); }
+
+    std::size_t segments() const { return count_ / 2; }
+    uint64_t dropped() const { return dropped_; }
+
+private:
+    struct Vertex {
+        glm::vec3 position;
+        glm::vec4 color;
+    };
+
+    std::size_t region_bytes() const { return max_vertices_ * sizeof(Vertex); }
+
+    void wait_region(int region) {
+        GLsync& fence = fences_[region];
+        if (!fence) return;
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    const std::size_t max_vertices_;
+    GLuint vao_ = 0;
+    GLuint vbo_ = 0;
+    GLsync fences_[kFrames] = {};
+    int region_ = 0;
+    Vertex* mapped_ = nullptr;
+    std::size_t count_ = 0;
+    std::size_t first_ = 0;
+    bool fence_pending_ = false;
+    uint64_t dropped_ = 0;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+// Level-of-detail selection. A LOD is good enough while its geometric error, projected
+// to the screen, stays under kLodPixelError pixels; the coarsest such LOD is drawn.
+// Going coarser needs a margin (kLodHysteresis), so an object sitting near a threshold
+// distance does not flip between two LODs every frame.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+constexpr float kLodPixelError = 1.0f;
+constexpr float kLodHysteresis = 0.75f; // a coarser LOD must be under this fraction of the limit
+
+// Screen pixels covered by one world unit at distance, for a vertical field of view
+// fovy (radians) over viewport_height pixels
+inline float pixels_per_unit(float distance, float fovy, float viewport_height) {
+    return viewport_height / (2.0f * std::max(distance, 1e-3f) * std::tan(fovy * 0.5f));
+}
+
+// errors: object-space error of each LOD, finest first and non-decreasing (Model::lodError);
+// current: the LOD drawn last frame
+inline std::size_t select_lod(const std::vector<float>& errors, float pixels_per_unit, std::size_t current) {
+    if (errors.empty()) return 0;
+    auto coarsest_within = [&](float limit) {
+        std::size_t lod = 0;
+        while (lod + 1 < errors.size() && errors[lod + 1] * pixels_per_unit <= limit) lod++;
+        return lod;
+    };
+    current = std::min(current, errors.size() - 1);
+    const std::size_t lod = coarsest_within(kLodPixelError);
+    if (lod <= current) return lod; // finer (or the same) right away
+    return std::max(current, coarsest_within(kLodPixelError * kLodHysteresis));
+}
@@ -4,16 +4,26 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "culling.h"
 #include "shader.h"
+#include "vertex_format.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <string>
 #include <vector>
 using namespace std;
 
-struct Vertex {
-    glm::vec3 Position;
-    glm::vec3 Normal;
-    glm::vec2 TexCoords;
+// dequantization of VertexFormat::Quantized positions (identity for the other formats)
+constexpr UniformId kPositionScaleUniform("positionScale");
+constexpr UniformId kPositionOffsetUniform("positionOffset");
+
+// One level of detail: a range of the mesh's index buffer over the shared vertices, and
+// how far (object space) its surface may stray from the full-detail one
+struct MeshLod {
+    uint32_t first = 0;
+    uint32_t count = 0;
+    float error = 0.0f;
 };
 
 struct Texture {
@@ -22,44 +32,92 @@ struct Texture {
     string path;
 };
 
-class Mesh {
-public:
-    // mesh Data
-    vector<Vertex>       vertices;
-    vector<unsigned int> indices;
-    vector<Texture>      textures;
-    unsigned int VAO;
-
-    // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures) {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
-        setupMesh();
-    }
-
-    // render the mesh
-    void Draw(Shader& shader) {
+// What a draw binds besides its vertex array: the textures, each with the sampler
+// uniform it goes to, and the dequantization of VertexFormat::Quantized positions
+struct Material {
+    vector<Texture> textures;
+    // "material.texture_diffuse1", ... named once instead of with string building on every draw
+    vector<UniformId> samplers;
+    glm::vec3 positionScale{ 1.0f };
+    glm::vec3 positionOffset{ 0.0f };
+
+    explicit Material(vector<Texture> textures = {}, glm::vec3 positionScale = glm::vec3(1.0f),
+                      glm::vec3 positionOffset = glm::vec3(0.0f))
+        : textures(std::move(textures)), positionScale(positionScale), positionOffset(positionOffset) {
         unsigned int diffuseNr = 1;
         unsigned int specularNr = 1;
-        for (unsigned int i = 0; i < textures.size(); i++) {
-            glActiveTexture(GL_TEXTURE0 + i); 
+        for (const Texture& texture : this->textures) {
             string number;
-            string name = textures[i].type;
+            const string& name = texture.type;
             if (name == "texture_diffuse")
                 number = std::to_string(diffuseNr++);
             else if (name == "texture_specular")
                 number = std::to_string(specularNr++);
-            
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
+            const string uniform = "material." + name + number;
+            samplers.emplace_back(std::string_view(uniform));
+        }
+    }
+
+    void bind(Shader& shader) const {
+        shader.setVec3(kPositionScaleUniform, positionScale);
+        shader.setVec3(kPositionOffsetUniform, positionOffset);
+        for (unsigned int i = 0; i < textures.size(); i++) {
+            glActiveTexture(GL_TEXTURE0 + i);
+            shader.setInt(samplers[i], i);
             glBindTexture(GL_TEXTURE_2D, textures[i].id);
         }
-        
-        // draw mesh
+    }
+};
+
+class Mesh {
+public:
+    // mesh Data; vertices and indices live only in GL buffers
+    Material material;
+    unsigned int VAO;              // LOD 0, same as lodVAOs[0]
+    vector<unsigned int> lodVAOs;  // one per LOD, so each can take instances from its own batch
+    vector<MeshLod> lods;          // finest first
+    GLsizei indexCount;            // all LODs
+    VertexFormat format;
+    AABB bounds{ glm::vec3(0.0f), glm::vec3(0.0f) }; // object space
+
+    // constructor
+    Mesh(const vector<Vertex>& vertices, const vector<unsigned int>& indices, vector<Texture> textures)
+        : Mesh(VertexFormat::Float, vertices.data(), vertices.size(), indices.data(), indices.size(), std::move(textures)) {
+        if (!vertices.empty()) bounds = { vertices[0].Position, vertices[0].Position };
+        for (const Vertex& v : vertices) bounds = { glm::min(bounds.min, v.Position), glm::max(bounds.max, v.Position) };
+    }
+
+    // uploads straight from caller memory, e.g. a mapped mesh cache; vertices are in
+    // `format` (see vertex_format.h). No lods means one covering all the indices.
+    Mesh(VertexFormat format, const void* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+         vector<Texture> textures, glm::vec3 positionScale = glm::vec3(1.0f), glm::vec3 positionOffset = glm::vec3(0.0f),
+         vector<MeshLod> lods = {})
+        : material(std::move(textures), positionScale, positionOffset) {
+        this->indexCount = static_cast<GLsizei>(indexCount);
+        this->lods = lods.empty() ? vector<MeshLod>{ { 0, static_cast<uint32_t>(indexCount), 0.0f } } : std::move(lods);
+        this->format = format;
+        setupMesh(vertices, vertexCount, indices, indexCount);
+    }
+
+    // render the mesh
+    void Draw(Shader& shader) {
+        material.bind(shader);
         glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+        glDrawElements(GL_TRIANGLES, lods[0].count, GL_UNSIGNED_INT, 0);
         glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+    }
 
+    // render `count` instances at one LOD; per-instance attributes come from whatever
+    // buffer was attached to lodVAOs[lod] (InstanceBatch::attach)
+    void DrawInstanced(Shader& shader, GLsizei count, size_t lod = 0) {
+        if (count <= 0) return;
+        lod = std::min(lod, lods.size() - 1);
+        material.bind(shader);
+        glBindVertexArray(lodVAOs[lod]);
+        glDrawElementsInstanced(GL_TRIANGLES, lods[lod].count, GL_UNSIGNED_INT,
+                                (void*)(lods[lod].first * sizeof(unsigned int)), count);
+        glBindVertexArray(0);
         glActiveTexture(GL_TEXTURE0);
     }
 
@@ -68,28 +126,45 @@ private:
     unsigned int VBO, EBO;
 
     // initializes all the buffer objects/arrays
-    void setupMesh() {
-        glGenVertexArrays(1, &VAO);
+    void setupMesh(const void* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount) {
+        lodVAOs.resize(lods.size());
+        glGenVertexArrays(static_cast<GLsizei>(lodVAOs.size()), lodVAOs.data());
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
-
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-        // vertex positions
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // vertex normals
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        // vertex texture coords
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+        VAO = lodVAOs[0];
+
+        // every LOD's VAO reads the same buffers; only its instance attributes differ
+        const GLsizei stride = static_cast<GLsizei>(vertex_stride(format));
+        for (size_t lod = 0; lod < lodVAOs.size(); lod++) {
+            glBindVertexArray(lodVAOs[lod]);
+            glBindBuffer(GL_ARRAY_BUFFER, VBO);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+            if (lod == 0) {
+                glBufferData(GL_ARRAY_BUFFER, vertexCount * stride, vertices, GL_STATIC_DRAW);
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+            }
+
+            glEnableVertexAttribArray(0);
+            glEnableVertexAttribArray(1);
+            glEnableVertexAttribArray(2);
+            switch (format) {
+            case VertexFormat::Float:
+                glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Vertex, Position));
+                glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Vertex, Normal));
+                glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Vertex, TexCoords));
+                break;
+            case VertexFormat::Packed:
+                glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, Position));
+                glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(PackedVertex, Normal));
+                glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, TexCoords));
+                break;
+            case VertexFormat::Quantized:
+                glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(QuantizedVertex, Position));
+                glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(QuantizedVertex, Normal));
+                glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(QuantizedVertex, TexCoords));
+                break;
+            }
+        }
 
         glBindVertexArray(0);
     }
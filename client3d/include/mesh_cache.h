@@ -0,0 +1,498 @@
+#pragma once
+// mesh_cache.h
+// Cooked models: what Model builds from an OBJ (deduplicated, cache-ordered meshes
+// split by material, with simplified LODs, and decoded textures) stored so that loading is a memory map and
+// a handful of glBufferData/glTexImage2D calls straight from the mapping.
+//
+// File layout (little-endian, every field and section 4-byte aligned):
+//   header   "GMSH" u32 version, u32 vertex_format, u32 source_count, u64 source_hash,
+//            u32 texture_count, u32 mesh_count
+//   sources  source_count * (u32 length, path)      files the cache was cooked from
+//   textures texture_count * (u32 width, u32 height, u32 channels, u32 length, path,
+//            width * height * channels pixel bytes)
+//   meshes   mesh_count * (u32 vertex_count, u32 index_count, u32 texture_count,
+//            texture_count * (u32 texture, u32 kind), f32 position_scale[3],
+//            f32 position_offset[3], f32 bounds_min[3], f32 bounds_max[3],
+//            u32 lod_count, lod_count * (u32 first, u32 count, f32 error),
+//            vertex_count vertices in vertex_format, u32[index_count])
+//
+// A mesh's LODs are ranges of its one index list, finest first, over the same vertices.
+//
+// Paths are relative to the model's directory. source_hash covers the contents of every
+// source (the OBJ, its material libraries and textures), so editing any of them, or a
+// change of format version or requested vertex format, makes Model cook the OBJ again.
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "tiny_obj_loader.h"
+
+#include "mapped_file.h"
+#include "mesh.h"
+#include "mesh_optimize.h"
+#include "log.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+constexpr uint32_t kMeshCacheVersion = 4;
+constexpr std::size_t kMeshLodCount = 4; // full detail, then about 1/2, 1/4 and 1/8 of the triangles
+constexpr char kMeshCacheMagic[4] = { 'G', 'M', 'S', 'H' };
+
+enum class TextureKind : uint32_t { Diffuse = 0, Specular = 1 };
+
+inline const char* texture_kind_name(TextureKind kind) {
+    return kind == TextureKind::Specular ? "texture_specular" : "texture_diffuse";
+}
+
+// Read-only views of a cooked model, pointing into a mapped cache file or a CookedModelData
+struct CookedTexture {
+    std::string path;
+    uint32_t width = 0, height = 0, channels = 0;
+    const uint8_t* pixels = nullptr;
+};
+
+struct CookedMesh {
+    const void* vertices = nullptr; // in CookedModel::format
+    uint32_t vertex_count = 0;
+    const uint32_t* indices = nullptr;
+    uint32_t index_count = 0;
+    std::vector<std::pair<uint32_t, TextureKind>> textures; // index into CookedModel::textures
+    glm::vec3 position_scale{ 1.0f };
+    glm::vec3 position_offset{ 0.0f };
+    glm::vec3 bounds_min{ 0.0f }; // object space
+    glm::vec3 bounds_max{ 0.0f };
+    std::vector<MeshLod> lods;
+};
+
+struct CookedModel {
+    VertexFormat format = VertexFormat::Float;
+    std::vector<CookedTexture> textures;
+    std::vector<CookedMesh> meshes;
+};
+
+// The output of cook_obj(), owning its data
+struct CookedModelData {
+    struct TextureData {
+        std::string path;
+        uint32_t width = 0, height = 0, channels = 0;
+        std::vector<uint8_t> pixels;
+    };
+    struct MeshData {
+        EncodedVertices vertices;
+        uint32_t vertex_count = 0;
+        std::vector<uint32_t> indices; // every LOD's, back to back
+        std::vector<MeshLod> lods;
+        std::vector<std::pair<uint32_t, TextureKind>> textures;
+    };
+
+    VertexFormat format = VertexFormat::Float;
+    std::vector<std::string> sources;
+    std::vector<TextureData> textures;
+    std::vector<MeshData> meshes;
+
+    CookedModel view() const {
+        CookedModel model;
+        model.format = format;
+        for (const TextureData& t : textures) model.textures.push_back({ t.path, t.width, t.height, t.channels, t.pixels.data() });
+        for (const MeshData& m : meshes) {
+            model.meshes.push_back({ m.vertices.bytes.data(), m.vertex_count,
+                                     m.indices.data(), static_cast<uint32_t>(m.indices.size()), m.textures,
+                                     m.vertices.positionScale, m.vertices.positionOffset,
+                                     m.vertices.boundsMin, m.vertices.boundsMax, m.lods });
+        }
+        return model;
+    }
+};
+
+// Directory part of a model path, "." for a bare file name
+inline std::string model_directory(const std::string& path) {
+    const std::size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+}
+
+// FNV-1a 64 over each source's name and contents; a missing file hashes as its name alone
+inline uint64_t hash_sources(const std::string& directory, const std::vector<std::string>& sources) {
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const uint8_t* p, std::size_t n) {
+        for (std::size_t i = 0; i < n; i++) { hash ^= p[i]; hash *= 1099511628211ull; }
+    };
+    for (const std::string& source : sources) {
+        mix(reinterpret_cast<const uint8_t*>(source.data()), source.size() + 1);
+        MappedFile file(directory + "/" + source);
+        if (file.data()) mix(file.data(), file.size());
+    }
+    return hash;
+}
+
+namespace mesh_cache_detail {
+
+// One OBJ corner: positions, normals and uvs are indexed separately in the file
+struct ObjIndex {
+    int vertex, normal, texcoord;
+    bool operator==(const ObjIndex& o) const { return vertex == o.vertex && normal == o.normal && texcoord == o.texcoord; }
+};
+struct ObjIndexHash {
+    std::size_t operator()(const ObjIndex& i) const {
+        std::size_t h = std::hash<int>()(i.vertex);
+        h = h * 31 + std::hash<int>()(i.normal);
+        return h * 31 + std::hash<int>()(i.texcoord);
+    }
+};
+
+inline Vertex make_vertex(const tinyobj::attrib_t& attrib, const tinyobj::index_t& index) {
+    Vertex vertex{};
+
+    vertex.Position = {
+        attrib.vertices[3 * index.vertex_index + 0],
+        attrib.vertices[3 * index.vertex_index + 1],
+        attrib.vertices[3 * index.vertex_index + 2]
+    };
+
+    if (index.normal_index >= 0) {
+        vertex.Normal = {
+            attrib.normals[3 * index.normal_index + 0],
+            attrib.normals[3 * index.normal_index + 1],
+            attrib.normals[3 * index.normal_index + 2]
+        };
+    }
+
+    if (index.texcoord_index >= 0) {
+        vertex.TexCoords = {
+            attrib.texcoords[2 * index.texcoord_index + 0],
+            1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
+        };
+    }
+    return vertex;
+}
+
+// "mtllib" statements of an OBJ, so material library edits invalidate the cache too
+inline std::vector<std::string> material_libraries(const std::string& path) {
+    std::vector<std::string> libraries;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, 7, "mtllib ") != 0) continue;
+        std::string name = line.substr(7);
+        while (!name.empty() && (name.back() == '\r' || name.back() == ' ')) name.pop_back();
+        if (!name.empty()) libraries.push_back(name);
+    }
+    return libraries;
+}
+
+class Reader {
+public:
+    Reader(const uint8_t* data, std::size_t size) : p_(data), end_(data + size) {}
+
+    bool ok() const { return ok_; }
+
+    uint32_t u32() { uint32_t v = 0; copy(&v, sizeof(v)); return v; }
+    uint64_t u64() { uint64_t v = 0; copy(&v, sizeof(v)); return v; }
+    std::string str() {
+        const uint32_t n = u32();
+        const uint8_t* s = take(n);
+        return s ? std::string(reinterpret_cast<const char*>(s), n) : std::string();
+    }
+    // n bytes in place, 4-byte aligned after; null once out of data
+    const uint8_t* take(std::size_t n) {
+        const std::size_t padded = (n + 3) & ~std::size_t(3);
+        if (!ok_ || static_cast<std::size_t>(end_ - p_) < padded) { ok_ = false; return nullptr; }
+        const uint8_t* at = p_;
+        p_ += padded;
+        return at;
+    }
+
+private:
+    void copy(void* out, std::size_t n) {
+        if (const uint8_t* at = take(n)) std::memcpy(out, at, n);
+    }
+
+    const uint8_t* p_;
+    const uint8_t* end_;
+    bool ok_ = true;
+};
+
+class Writer {
+public:
+    explicit Writer(std::ofstream& out) : out_(out) {}
+
+    void u32(uint32_t v) { bytes(&v, sizeof(v)); }
+    void u64(uint64_t v) { bytes(&v, sizeof(v)); }
+    void str(const std::string& s) { u32(static_cast<uint32_t>(s.size())); bytes(s.data(), s.size()); }
+    void bytes(const void* p, std::size_t n) {
+        static const char kZeros[4] = {};
+        out_.write(static_cast<const char*>(p), static_cast<std::streamsize>(n));
+        out_.write(kZeros, static_cast<std::streamsize>(((n + 3) & ~std::size_t(3)) - n));
+    }
+
+private:
+    std::ofstream& out_;
+};
+
+} // namespace mesh_cache_detail
+
+// Parses the OBJ and its materials, deduplicates and reorders each per-material submesh
+// encodes its vertices in format and decodes the textures. Throws std::runtime_error if
+// the OBJ cannot be read.
+inline CookedModelData cook_obj(const std::string& path, VertexFormat format) {
+    using namespace mesh_cache_detail;
+
+    const std::string directory = model_directory(path);
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warn, err;
+
+    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str(), (directory + "/").c_str())) {
+// Requirements: QCSIDM_SRS_012, QCSIDM_SRS_087, QCSIDM_SRS_102, QCSIDM_SRS_111, QCSIDM_SRS_116, QCSIDM_SRS_196, QCSIDM_SRS_200
+        throw std::runtime_error(warn + err);
+    }
+
+    CookedModelData cooked;
+    cooked.format = format;
+    cooked.sources.push_back(path.substr(path.find_last_of('/') + 1));
+    for (std::string& library : material_libraries(path)) cooked.sources.push_back(std::move(library));
+
+    // Textures by file name, each decoded once however many materials use it
+    std::map<std::string, uint32_t> texture_slots;
+    auto texture_index = [&](const std::string& file) -> int {
+        auto found = texture_slots.find(file);
+        if (found != texture_slots.end()) return static_cast<int>(found->second);
+        cooked.sources.push_back(file);
+        int width, height, channels;
+        unsigned char* data = stbi_load((directory + "/" + file).c_str(), &width, &height, &channels, 0);
+        if (!data) {
+            LOG_WARN("[Model] Texture failed to load: {}", file);
+            return -1;
+        }
+        CookedModelData::TextureData texture;
+        texture.path = file;
+        texture.width = static_cast<uint32_t>(width);
+        texture.height = static_cast<uint32_t>(height);
+        texture.channels = static_cast<uint32_t>(channels);
+        texture.pixels.assign(data, data + static_cast<std::size_t>(width) * height * channels);
+        stbi_image_free(data);
+        texture_slots.emplace(file, static_cast<uint32_t>(cooked.textures.size()));
+        cooked.textures.push_back(std::move(texture));
+        return static_cast<int>(cooked.textures.size() - 1);
+    };
+
+    // faces of one shape that use one material
+    struct SubMesh {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::unordered_map<ObjIndex, uint32_t, ObjIndexHash> lookup;
+    };
+
+    std::size_t corners = 0, unique = 0;
+    std::size_t lod_triangles[kMeshLodCount] = {};
+    float acmr_before = 0.0f, acmr_after = 0.0f;
+    for (const auto& shape : shapes) {
+        // Split by material and share identical corners; faces are triangles (LoadObj triangulates)
+        std::map<int, SubMesh> submeshes;
+        for (std::size_t f = 0; f < shape.mesh.indices.size() / 3; f++) {
+            const int material = f < shape.mesh.material_ids.size() ? shape.mesh.material_ids[f] : -1;
+            SubMesh& sub = submeshes[material];
+            for (std::size_t k = 0; k < 3; k++) {
+                const tinyobj::index_t& index = shape.mesh.indices[3 * f + k];
+                const ObjIndex key{ index.vertex_index, index.normal_index, index.texcoord_index };
+                auto found = sub.lookup.find(key);
+                if (found == sub.lookup.end()) {
+                    found = sub.lookup.emplace(key, static_cast<uint32_t>(sub.vertices.size())).first;
+                    sub.vertices.push_back(make_vertex(attrib, index));
+                }
+                sub.indices.push_back(found->second);
+            }
+        }
+
+        for (auto& [material, sub] : submeshes) {
+            corners += sub.indices.size();
+            unique += sub.vertices.size();
+            const float triangles = static_cast<float>(sub.indices.size() / 3);
+            acmr_before += mesh_optimize::average_cache_miss_ratio(sub.indices, sub.vertices.size()) * triangles;
+            mesh_optimize::optimize_vertex_cache(sub.indices, sub.vertices.size());
+            mesh_optimize::optimize_vertex_fetch(sub.vertices, sub.indices);
+            acmr_after += mesh_optimize::average_cache_miss_ratio(sub.indices, sub.vertices.size()) * triangles;
+
+            CookedModelData::MeshData mesh;
+            mesh.vertices = encode_vertices(sub.vertices, format);
+            mesh.vertex_count = static_cast<uint32_t>(sub.vertices.size());
+            mesh.indices = sub.indices;
+            mesh.lods.push_back({ 0, static_cast<uint32_t>(sub.indices.size()), 0.0f });
+            for (std::size_t level = 1; level < kMeshLodCount; level++) {
+                // Each level simplifies the full mesh, so errors do not compound. When a
+                // level stalls (seams, borders) the coarser ones repeat it: every mesh keeps
+                // kMeshLodCount LODs and a model's LODs line up across its meshes.
+                const MeshLod previous = mesh.lods.back();
+                float error = 0.0f;
+                std::vector<unsigned int> lod = mesh_optimize::simplify(sub.indices, sub.vertices, sub.indices.size() >> level, &error);
+                if (lod.empty() || lod.size() > previous.count * 9 / 10) {
+                    mesh.lods.push_back(previous);
+                } else {
+                    mesh_optimize::optimize_vertex_cache(lod, sub.vertices.size());
+                    mesh.lods.push_back({ static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(lod.size()),
+                                          std::max(error, previous.error) });
+                    mesh.indices.insert(mesh.indices.end(), lod.begin(), lod.end());
+                }
+                lod_triangles[level] += mesh.lods.back().count / 3;
+            }
+            if (material >= 0 && material < static_cast<int>(materials.size())) {
+                const std::pair<const std::string*, TextureKind> slots[] = {
+                    { &materials[material].diffuse_texname, TextureKind::Diffuse },
+                    { &materials[material].specular_texname, TextureKind::Specular },
+                };
+                for (const auto& [file, kind] : slots) {
+                    if (file->empty()) continue;
+                    const int index = texture_index(*file);
+                    if (index >= 0) mesh.textures.emplace_back(static_cast<uint32_t>(index), kind);
+                }
+            }
+            cooked.meshes.push_back(std::move(mesh));
+        }
+    }
+    const float triangles = static_cast<float>(std::max<std::size_t>(corners / 3, 1));
+    LOG_INFO("[Model] {}: cooked {} meshes, {} triangles, {} unique vertices of {} corners, ACMR {} -> {}",
+             path, cooked.meshes.size(), corners / 3, unique, corners, acmr_before / triangles, acmr_after / triangles);
+    LOG_INFO("[Model] {}: simplified LODs {} / {} / {} triangles", path, lod_triangles[1], lod_triangles[2], lod_triangles[3]);
+    return cooked;
+}
+
+// Writes to a temporary file and renames it over cache_path, so a crash never leaves a
+// truncated cache behind. False on any IO error.
+inline bool write_mesh_cache(const std::string& cache_path, const CookedModelData& cooked, uint64_t source_hash) {
+    const std::string temp_path = cache_path + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        mesh_cache_detail::Writer w(out);
+        w.bytes(kMeshCacheMagic, sizeof(kMeshCacheMagic));
+        w.u32(kMeshCacheVersion);
+        w.u32(static_cast<uint32_t>(cooked.format));
+        w.u32(static_cast<uint32_t>(cooked.sources.size()));
+        w.u64(source_hash);
+        w.u32(static_cast<uint32_t>(cooked.textures.size()));
+        w.u32(static_cast<uint32_t>(cooked.meshes.size()));
+        for (const std::string& source : cooked.sources) w.str(source);
+        for (const auto& texture : cooked.textures) {
+            w.u32(texture.width);
+            w.u32(texture.height);
+            w.u32(texture.channels);
+            w.str(texture.path);
+            w.bytes(texture.pixels.data(), texture.pixels.size());
+        }
+        for (const auto& mesh : cooked.meshes) {
+            w.u32(mesh.vertex_count);
+            w.u32(static_cast<uint32_t>(mesh.indices.size()));
+            w.u32(static_cast<uint32_t>(mesh.textures.size()));
+            for (const auto& [texture, kind] : mesh.textures) {
+                w.u32(texture);
+                w.u32(static_cast<uint32_t>(kind));
+            }
+            w.bytes(&mesh.vertices.positionScale[0], 3 * sizeof(float));
+            w.bytes(&mesh.vertices.positionOffset[0], 3 * sizeof(float));
+            w.bytes(&mesh.vertices.boundsMin[0], 3 * sizeof(float));
+            w.bytes(&mesh.vertices.boundsMax[0], 3 * sizeof(float));
+            w.u32(static_cast<uint32_t>(mesh.lods.size()));
+            for (const MeshLod& lod : mesh.lods) {
+                w.u32(lod.first);
+                w.u32(lod.count);
+                w.bytes(&lod.error, sizeof(float));
+            }
+            w.bytes(mesh.vertices.bytes.data(), mesh.vertices.bytes.size());
+            w.bytes(mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+        }
+        if (!out.flush()) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp_path, cache_path, ec);
+    if (ec) std::filesystem::remove(temp_path, ec);
+    return !ec;
+}
+
+// A mapped cache file. valid() is false if it is missing, truncated, or written by a
+// different format version; the views stay valid while this lives.
+class MeshCacheFile {
+public:
+    explicit MeshCacheFile(const std::string& path) : file_(path) {
+        if (!file_.data()) return;
+        mesh_cache_detail::Reader r(file_.data(), file_.size());
+        const uint8_t* magic = r.take(sizeof(kMeshCacheMagic));
+        if (!magic || std::memcmp(magic, kMeshCacheMagic, sizeof(kMeshCacheMagic)) != 0) return;
+        if (r.u32() != kMeshCacheVersion) return;
+        const uint32_t format = r.u32();
+        if (format > static_cast<uint32_t>(VertexFormat::Quantized)) return;
+        model_.format = static_cast<VertexFormat>(format);
+        const uint32_t source_count = r.u32();
+        source_hash_ = r.u64();
+        const uint32_t texture_count = r.u32();
+        const uint32_t mesh_count = r.u32();
+        if (!r.ok()) return;
+
+        for (uint32_t i = 0; i < source_count && r.ok(); i++) sources_.push_back(r.str());
+        for (uint32_t i = 0; i < texture_count && r.ok(); i++) {
+            CookedTexture texture;
+            texture.width = r.u32();
+            texture.height = r.u32();
+            texture.channels = r.u32();
+            texture.path = r.str();
+            texture.pixels = r.take(static_cast<std::size_t>(texture.width) * texture.height * texture.channels);
+            model_.textures.push_back(std::move(texture));
+        }
+        for (uint32_t i = 0; i < mesh_count && r.ok(); i++) {
+            CookedMesh mesh;
+            mesh.vertex_count = r.u32();
+            mesh.index_count = r.u32();
+            const uint32_t textures = r.u32();
+            for (uint32_t t = 0; t < textures && r.ok(); t++) {
+                const uint32_t texture = r.u32();
+                const uint32_t kind = r.u32();
+                if (texture >= texture_count || kind > static_cast<uint32_t>(TextureKind::Specular)) return;
+                mesh.textures.emplace_back(texture, static_cast<TextureKind>(kind));
+            }
+            if (const uint8_t* ranges = r.take(12 * sizeof(float))) {
+                std::memcpy(&mesh.position_scale[0], ranges, 3 * sizeof(float));
+                std::memcpy(&mesh.position_offset[0], ranges + 3 * sizeof(float), 3 * sizeof(float));
+                std::memcpy(&mesh.bounds_min[0], ranges + 6 * sizeof(float), 3 * sizeof(float));
+                std::memcpy(&mesh.bounds_max[0], ranges + 9 * sizeof(float), 3 * sizeof(float));
+            }
+            const uint32_t lods = r.u32();
+            for (uint32_t l = 0; l < lods && r.ok(); l++) {
+                MeshLod lod;
+                lod.first = r.u32();
+                lod.count = r.u32();
+                if (const uint8_t* error = r.take(sizeof(float))) std::memcpy(&lod.error, error, sizeof(float));
+                if (lod.count % 3 != 0 || lod.first > mesh.index_count || lod.count > mesh.index_count - lod.first) return;
+                mesh.lods.push_back(lod);
+            }
+            if (mesh.lods.empty()) return;
+            mesh.vertices = r.take(static_cast<std::size_t>(mesh.vertex_count) * vertex_stride(model_.format));
+            mesh.indices = reinterpret_cast<const uint32_t*>(r.take(static_cast<std::size_t>(mesh.index_count) * sizeof(uint32_t)));
+            if (!r.ok()) return;
+            for (uint32_t k = 0; k < mesh.index_count; k++)
+                if (mesh.indices[k] >= mesh.vertex_count) return;
+            model_.meshes.push_back(std::move(mesh));
+        }
+        valid_ = r.ok();
+    }
+
+    bool valid() const { return valid_; }
+    uint64_t source_hash() const { return source_hash_; }
+    const std::vector<std::string>& sources() const { return sources_; }
+    const CookedModel& model() const { return model_; }
+
+private:
+    MappedFile file_;
+    bool valid_ = false;
+    uint64_t source_hash_ = 0;
+    std::vector<std::string> sources_;
+    CookedModel model_;
+};
@@ -0,0 +1,346 @@
+#pragma once
+
+// Index and vertex reordering for indexed triangle lists.
+//
+// optimize_vertex_cache() reorders triangles so consecutive ones share vertices still
+// in the GPU's post-transform cache (Tom Forsyth, "Linear-Speed Vertex Cache
+// Optimisation"); optimize_vertex_fetch() then renumbers vertices in first-use order so
+// the vertex buffer is read front to back.
+//
+// simplify() builds a lower-detail index list over the same vertices by quadric error
+// edge collapse (Garland and Heckbert, "Surface Simplification Using Quadric Error
+// Metrics"), which is how the mesh cache cooks its LODs.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace mesh_optimize {
+
+constexpr int kCacheSize = 32; // simulated cache; larger than any real FIFO so it stays useful everywhere
+
+inline float vertex_score(int cache_position, uint32_t remaining) {
+    if (remaining == 0) return -1.0f; // no triangles left to pull in
+    float score = 0.0f;
+    if (cache_position >= 0) {
+        // the last triangle's vertices score the same whatever their order
+        score = cache_position < 3 ? 0.75f
+              : std::pow(1.0f - (cache_position - 3) * (1.0f / (kCacheSize - 3)), 1.5f);
+    }
+    // favour vertices with few triangles left, so they get finished and leave the working set
+    return score + 2.0f / std::sqrt(static_cast<float>(remaining));
+}
+
+inline void optimize_vertex_cache(std::vector<unsigned int>& indices, std::size_t vertex_count) {
+    const std::size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0) return;
+
+    // vertex -> triangles using it; the live ones are [offset[v], offset[v] + remaining[v])
+    std::vector<uint32_t> remaining(vertex_count, 0);
+    for (unsigned int v : indices) remaining[v]++;
+    std::vector<uint32_t> offset(vertex_count + 1, 0);
+    for (std::size_t v = 0; v < vertex_count; v++) offset[v + 1] = offset[v] + remaining[v];
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<uint32_t> fill(offset.begin(), offset.end() - 1);
+        for (std::size_t i = 0; i < indices.size(); i++) adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<int> cache_position(vertex_count, -1);
+    std::vector<float> vertex_scores(vertex_count);
+    for (std::size_t v = 0; v < vertex_count; v++) vertex_scores[v] = vertex_score(-1, remaining[v]);
+
+    std::vector<float> triangle_scores(triangle_count);
+    std::vector<char> emitted(triangle_count, 0);
+    std::size_t best = 0;
+    for (std::size_t t = 0; t < triangle_count; t++) {
+        triangle_scores[t] = vertex_scores[indices[3 * t]] + vertex_scores[indices[3 * t + 1]] + vertex_scores[indices[3 * t + 2]];
+        if (triangle_scores[t] > triangle_scores[best]) best = t;
+    }
+
+    std::vector<unsigned int> out;
+    out.reserve(indices.size());
+    unsigned int cache[kCacheSize + 3];
+    int cache_count = 0;
+    std::size_t scan = 0; // next candidate when the cache has nothing to offer
+
+    for (std::size_t n = 0; n < triangle_count; n++) {
+        if (best == SIZE_MAX) {
+            while (emitted[scan]) scan++;
+            best = scan;
+        }
+        const unsigned int* tri = &indices[3 * best];
+        out.insert(out.end(), tri, tri + 3);
+        emitted[best] = 1;
+
+        for (int k = 0; k < 3; k++) {
+            const unsigned int v = tri[k];
+            uint32_t* list = &adjacency[offset[v]];
+            for (uint32_t i = 0; i < remaining[v]; i++) {
+                if (list[i] == best) { list[i] = list[--remaining[v]]; break; }
+            }
+        }
+
+        // the triangle's vertices move to the front, the rest shift back and may fall out
+        unsigned int next[kCacheSize + 3];
+        int next_count = 0;
+        for (int k = 0; k < 3; k++) next[next_count++] = tri[k];
+        for (int i = 0; i < cache_count; i++) {
+            if (cache[i] != tri[0] && cache[i] != tri[1] && cache[i] != tri[2]) next[next_count++] = cache[i];
+        }
+        for (int i = 0; i < next_count; i++) {
+            const unsigned int v = next[i];
+            cache_position[v] = i < kCacheSize ? i : -1;
+            vertex_scores[v] = vertex_score(cache_position[v], remaining[v]);
+        }
+
+        // only triangles touching those vertices changed score; the best of them goes next
+        best = SIZE_MAX;
+        float best_score = -1.0f;
+        for (int i = 0; i < next_count; i++) {
+            const unsigned int v = next[i];
+            for (uint32_t j = 0; j < remaining[v]; j++) {
+                const uint32_t t = adjacency[offset[v] + j];
+                const float score = vertex_scores[indices[3 * t]] + vertex_scores[indices[3 * t + 1]] + vertex_scores[indices[3 * t + 2]];
+                triangle_scores[t] = score;
+                if (score > best_score) { best_score = score; best = t; }
+            }
+        }
+
+        cache_count = std::min(next_count, kCacheSize);
+        std::copy(next, next + cache_count, cache);
+    }
+    indices.swap(out);
+}
+
+// Renumbers vertices in order of first use and drops unreferenced ones
+template <typename VertexT>
+void optimize_vertex_fetch(std::vector<VertexT>& vertices, std::vector<unsigned int>& indices) {
+    constexpr unsigned int kUnmapped = ~0u;
+    std::vector<unsigned int> remap(vertices.size(), kUnmapped);
+    std::vector<VertexT> reordered;
+    reordered.reserve(vertices.size());
+    for (unsigned int& index : indices) {
+        if (remap[index] == kUnmapped) {
+            remap[index] = static_cast<unsigned int>(reordered.size());
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(reordered);
+}
+
+// Average cache miss ratio (transformed vertices per triangle) for a FIFO of the given
+// size: 3 is no reuse at all, 0.5-0.7 is typical of well ordered meshes
+inline float average_cache_miss_ratio(const std::vector<unsigned int>& indices, std::size_t vertex_count, std::size_t fifo_size = 16) {
+    if (indices.empty()) return 0.0f;
+    std::vector<std::size_t> stamp(vertex_count, 0);
+    std::size_t time = fifo_size + 1, misses = 0;
+    for (unsigned int v : indices) {
+        if (time - stamp[v] > fifo_size) { stamp[v] = time++; misses++; }
+    }
+    return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+}
+
+namespace detail {
+
+// Area-weighted sum of squared distances to a set of planes, as the symmetric 4x4
+// matrix of a*a, a*b, a*c, a*d, b*b, b*c, b*d, c*c, c*d, d*d
+struct Quadric {
+    double m[10] = {};
+    double weight = 0.0;
+
+    void addPlane(double a, double b, double c, double d, double w) {
+        const double p[4] = { a, b, c, d };
+        int k = 0;
+        for (int i = 0; i < 4; i++)
+            for (int j = i; j < 4; j++) m[k++] += w * p[i] * p[j];
+        weight += w;
+    }
+    void add(const Quadric& o) {
+        for (int i = 0; i < 10; i++) m[i] += o.m[i];
+        weight += o.weight;
+    }
+    // mean squared distance over the planes' area
+    double error(double x, double y, double z) const {
+        const double e = m[0] * x * x + 2 * m[1] * x * y + 2 * m[2] * x * z + 2 * m[3] * x
+                       + m[4] * y * y + 2 * m[5] * y * z + 2 * m[6] * y
+                       + m[7] * z * z + 2 * m[8] * z
+                       + m[9];
+        return e > 0.0 && weight > 0.0 ? e / weight : 0.0;
+    }
+};
+
+struct Vec3d {
+    double x, y, z;
+};
+inline Vec3d sub(const Vec3d& a, const Vec3d& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+inline Vec3d cross(const Vec3d& a, const Vec3d& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+inline double dot(const Vec3d& a, const Vec3d& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+} // namespace detail
+
+// Collapses edges, cheapest first, until at most target_index_count indices remain or
+// nothing more can go; returns the new index list, which references the input vertices.
+// Vertices on open borders and attribute seams (several vertices at one position) never
+// move, so the silhouette and UV layout hold, at the price of stopping early on meshes
+// that are mostly seams. error, if given, receives the largest collapse error as an
+// object-space distance (RMS over the surface a collapsed vertex stood for).
+template <typename VertexT>
+std::vector<unsigned int> simplify(const std::vector<unsigned int>& indices, const std::vector<VertexT>& vertices,
+                                   std::size_t target_index_count, float* error = nullptr) {
+    using detail::Vec3d;
+    const std::size_t vertex_count = vertices.size();
+    std::vector<Vec3d> position(vertex_count);
+    for (std::size_t v = 0; v < vertex_count; v++)
+        position[v] = { vertices[v].Position.x, vertices[v].Position.y, vertices[v].Position.z };
+
+    // Lock seams: the first vertex at each position stands for all of them
+    std::vector<unsigned int> wedge(vertex_count);
+    std::vector<char> locked(vertex_count, 0);
+    {
+        struct Key {
+            float p[3];
+            bool operator==(const Key& o) const { return std::memcmp(p, o.p, sizeof(p)) == 0; }
+        };
+        struct KeyHash {
+            std::size_t operator()(const Key& k) const {
+                uint32_t b[3];
+                std::memcpy(b, k.p, sizeof(b));
+                return (b[0] * 73856093u) ^ (b[1] * 19349663u) ^ (b[2] * 83492791u);
+            }
+        };
+        std::unordered_map<Key, unsigned int, KeyHash> first;
+        for (std::size_t v = 0; v < vertex_count; v++) {
+            const Key key{ { vertices[v].Position.x, vertices[v].Position.y, vertices[v].Position.z } };
+            auto [found, inserted] = first.emplace(key, static_cast<unsigned int>(v));
+            wedge[v] = found->second;
+            if (!inserted) locked[v] = locked[found->second] = 1;
+        }
+    }
+    // ...and borders: edges (by position) used by one triangle only
+    {
+        std::unordered_map<uint64_t, uint32_t> edges;
+        auto edge_key = [&wedge](unsigned int a, unsigned int b) {
+            a = wedge[a];
+            b = wedge[b];
+            if (a > b) std::swap(a, b);
+            return (static_cast<uint64_t>(a) << 32) | b;
+        };
+        for (std::size_t i = 0; i < indices.size(); i += 3)
+            for (int k = 0; k < 3; k++) edges[edge_key(indices[i + k], indices[i + (k + 1) % 3])]++;
+        for (std::size_t i = 0; i < indices.size(); i += 3) {
+            for (int k = 0; k < 3; k++) {
+                const unsigned int a = indices[i + k], b = indices[i + (k + 1) % 3];
+                if (edges[edge_key(a, b)] == 1) locked[a] = locked[b] = 1;
+            }
+        }
+    }
+    for (std::size_t v = 0; v < vertex_count; v++)
+        if (locked[wedge[v]]) locked[v] = 1;
+
+    std::vector<detail::Quadric> quadric(vertex_count);
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const Vec3d& a = position[indices[i]];
+        const Vec3d n = detail::cross(detail::sub(position[indices[i + 1]], a), detail::sub(position[indices[i + 2]], a));
+        const double length = std::sqrt(detail::dot(n, n));
+        if (length <= 0.0) continue;
+        const Vec3d u{ n.x / length, n.y / length, n.z / length };
+        detail::Quadric q;
+        q.addPlane(u.x, u.y, u.z, -detail::dot(u, a), 0.5 * length);
+        for (int k = 0; k < 3; k++) quadric[indices[i + k]].add(q);
+    }
+
+    struct Collapse {
+        unsigned int from, to;
+        double cost;
+    };
+    std::vector<unsigned int> result = indices;
+    std::vector<unsigned int> remap(vertex_count);
+    std::vector<char> touched(vertex_count);
+    std::vector<uint32_t> offset(vertex_count + 1), adjacency;
+    std::vector<Collapse> collapses;
+    double max_error = 0.0;
+    target_index_count -= target_index_count % 3;
+
+    while (result.size() > target_index_count) {
+        // vertex -> triangles of the current result
+        std::fill(offset.begin(), offset.end(), 0);
+        for (unsigned int v : result) offset[v + 1]++;
+        for (std::size_t v = 0; v < vertex_count; v++) offset[v + 1] += offset[v];
+        adjacency.resize(result.size());
+        {
+            std::vector<uint32_t> fill(offset.begin(), offset.end() - 1);
+            for (std::size_t i = 0; i < result.size(); i++) adjacency[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        collapses.clear();
+        auto consider = [&](unsigned int from, unsigned int to) {
+            if (locked[from]) return;
+            detail::Quadric q = quadric[from];
+            q.add(quadric[to]);
+            collapses.push_back({ from, to, q.error(position[to].x, position[to].y, position[to].z) });
+        };
+        for (std::size_t i = 0; i < result.size(); i += 3) {
+            for (int k = 0; k < 3; k++) {
+                consider(result[i + k], result[i + (k + 1) % 3]);
+                consider(result[i + (k + 1) % 3], result[i + k]);
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        // Take the cheapest independent collapses of this pass; each removes about two triangles
+        for (std::size_t v = 0; v < vertex_count; v++) remap[v] = static_cast<unsigned int>(v);
+        std::fill(touched.begin(), touched.end(), 0);
+        const std::size_t goal = (result.size() - target_index_count) / 3;
+        std::size_t removed = 0;
+        for (const Collapse& c : collapses) {
+            if (removed >= goal) break;
+            if (touched[c.from] || touched[c.to]) continue;
+
+            // refuse collapses that fold a surviving triangle over
+            bool flips = false;
+            for (uint32_t t = offset[c.from]; t < offset[c.from + 1] && !flips; t++) {
+                const unsigned int* tri = &result[adjacency[t] * 3];
+                if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) continue;
+                Vec3d p[3], q[3];
+                for (int k = 0; k < 3; k++) {
+                    p[k] = position[tri[k]];
+                    q[k] = tri[k] == c.from ? position[c.to] : p[k];
+                }
+                const Vec3d before = detail::cross(detail::sub(p[1], p[0]), detail::sub(p[2], p[0]));
+                const Vec3d after = detail::cross(detail::sub(q[1], q[0]), detail::sub(q[2], q[0]));
+                flips = detail::dot(before, after) <= 0.0;
+            }
+            if (flips) continue;
+
+            remap[c.from] = c.to;
+            quadric[c.to].add(quadric[c.from]);
+            for (uint32_t t = offset[c.from]; t < offset[c.from + 1]; t++) {
+                const unsigned int* tri = &result[adjacency[t] * 3];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1;
+                if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) removed++;
+            }
+            max_error = std::max(max_error, c.cost);
+        }
+        if (removed == 0) break;
+
+        std::size_t write = 0;
+        for (std::size_t i = 0; i < result.size(); i += 3) {
+            const unsigned int a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+            if (a == b || b == c || a == c) continue;
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+    if (error) *error = static_cast<float>(std::sqrt(max_error));
+    return result;
+}
+
+} // namespace mesh_optimize
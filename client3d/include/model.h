@@ -4,31 +4,66 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
-
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "tiny_obj_loader.h"
 
 #include "mesh.h"
+#include "mesh_cache.h"
 #include "shader.h"
+#include "log.h"
 
+#include <algorithm>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
-#include <map>
+#include <memory>
 #include <vector>
 
 using namespace std;
 
+// The CPU half of loading a model, safe on any thread: the mapped cache if it was cooked
+// from the current sources, otherwise a fresh cook of the OBJ (written back as the cache).
+// model() stays valid while this lives.
+class ModelSource {
+public:
+    ModelSource(const string& path, VertexFormat format) {
+        const string directory = model_directory(path);
+        const string cachePath = path + ".gmsh";
+        cache = std::make_unique<MeshCacheFile>(cachePath);
+        if (cache->valid() && cache->model().format == format &&
+            cache->source_hash() == hash_sources(directory, cache->sources())) {
+            LOG_INFO("[Model] {}: {} meshes from {}", path, cache->model().meshes.size(), cachePath);
+            return;
+        }
+        cache.reset();
+        cooked = cook_obj(path, format);
+        view = cooked.view();
+        if (!write_mesh_cache(cachePath, cooked, hash_sources(directory, cooked.sources)))
+            LOG_WARN("[Model] Could not write mesh cache {}", cachePath);
+    }
+
+    const CookedModel& model() const { return cache ? cache->model() : view; }
+
+private:
+    std::unique_ptr<MeshCacheFile> cache;
+    CookedModelData cooked;
+    CookedModel view;
+};
+
 class Model {
 public:
     vector<Mesh> meshes;
     string directory;
+    AABB bounds{ glm::vec3(0.0f), glm::vec3(0.0f) }; // object space, of the meshes uploaded so far
+
+    // empty; filled by uploadNext() (see AssetManager)
+    Model() = default;
 
-    Model(string const &path) {
-        loadModel(path);
+    // Loads synchronously: path + ".gmsh" if it was cooked from the current sources,
+    // otherwise cooks the OBJ and (re)writes that cache for the next start
+    Model(string const &path, VertexFormat format = kDefaultVertexFormat) {
+        directory = model_directory(path);
+        ModelSource source(path, format);
+        while (uploadNext(source.model())) {}
     }
 
     void Draw(Shader& shader) {
@@ -36,56 +71,63 @@ public:
             meshes[i].Draw(shader);
     }
 
-private:
-    void loadModel(string const &path) {
-        tinyobj::attrib_t attrib;
-        vector<tinyobj::shape_t> shapes;
-        vector<tinyobj::material_t> materials;
-        string warn, err;
-
-        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str())) {
-// Requirements: QCSIDM_SRS_012, QCSIDM_SRS_087, QCSIDM_SRS_102, QCSIDM_SRS_111, QCSIDM_SRS_116, QCSIDM_SRS_196, QCSIDM_SRS_200
-            throw std::runtime_error(warn + err);
-        }
+    // one instanced draw per mesh
+    void DrawInstanced(Shader& shader, GLsizei count, size_t lod = 0) {
+        for (unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].DrawInstanced(shader, count, lod);
+    }
+
+    // LODs every mesh has (cooked models: kMeshLodCount)
+    size_t lodCount() const {
+        size_t count = meshes.empty() ? 1 : meshes[0].lods.size();
+        for (const Mesh& mesh : meshes) count = std::min(count, mesh.lods.size());
+        return count;
+    }
+
+    // object-space error of a LOD: the worst of its meshes
+    float lodError(size_t lod) const {
+        float error = 0.0f;
+        for (const Mesh& mesh : meshes) error = std::max(error, mesh.lods[std::min(lod, mesh.lods.size() - 1)].error);
+        return error;
+    }
 
-        directory = path.substr(0, path.find_last_of('/'));
-
-        for (const auto& shape : shapes) {
-            vector<Vertex> vertices;
-            vector<unsigned int> indices;
-            
-            for (const auto& index : shape.mesh.indices) {
-                Vertex vertex{};
-
-                vertex.Position = {
-                    attrib.vertices[3 * index.vertex_index + 0],
-                    attrib.vertices[3 * index.vertex_index + 1],
-                    attrib.vertices[3 * index.vertex_index + 2]
-                };
-
-                if (index.normal_index >= 0) {
-                    vertex.Normal = {
-                        attrib.normals[3 * index.normal_index + 0],
-                        attrib.normals[3 * index.normal_index + 1],
-                        attrib.normals[3 * index.normal_index + 2]
-                    };
-                }
-
-                if (index.texcoord_index >= 0) {
-                    vertex.TexCoords = {
-                        attrib.texcoords[2 * index.texcoord_index + 0],
-                        1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-                    };
-                }
-                
-                vertices.push_back(vertex);
-                indices.push_back(indices.size());
-            }
-
-            // For simplicity, we are not loading textures from materials here.
-            // You can extend this part to load textures based on material info if needed.
-            vector<Texture> textures; 
-            meshes.push_back(Mesh(vertices, indices, textures));
+    // GL half of loading, render thread only: uploads the next texture of model or, once
+    // those are done, the next mesh. Returns false when there is nothing left to upload.
+    bool uploadNext(const CookedModel& model) {
+        if (textureIds.size() < model.textures.size()) {
+            textureIds.push_back(TextureFromPixels(model.textures[textureIds.size()]));
+            return true;
+        }
+        if (meshes.size() < model.meshes.size()) {
+            const CookedMesh& mesh = model.meshes[meshes.size()];
+            vector<Texture> textures;
+            for (const auto& [index, kind] : mesh.textures)
+                textures.push_back({ textureIds[index], texture_kind_name(kind), model.textures[index].path });
+            meshes.emplace_back(model.format, mesh.vertices, mesh.vertex_count, mesh.indices, mesh.index_count,
+                                std::move(textures), mesh.position_scale, mesh.position_offset, mesh.lods);
+            meshes.back().bounds = { mesh.bounds_min, mesh.bounds_max };
+            bounds = meshes.size() == 1 ? meshes.back().bounds : merge(bounds, meshes.back().bounds);
+            return meshes.size() < model.meshes.size();
         }
+        return false;
+    }
+
+private:
+    vector<unsigned int> textureIds;
+
+    static unsigned int TextureFromPixels(const CookedTexture& texture) {
+        GLenum format = texture.channels == 1 ? GL_RED : texture.channels == 3 ? GL_RGB : GL_RGBA;
+        unsigned int textureID;
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, texture.width, texture.height, 0, format, GL_UNSIGNED_BYTE, texture.pixels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        return textureID;
     }
 };
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed-capacity pool of short-lived straight-line particles: projectile tracers and
+// hit effects. Stored as structure of arrays so update() is one linear pass over
+// plain float arrays the compiler can vectorize; dead particles are swap-removed, so
+// the live ones stay packed in [0, size()). All storage is allocated up front, so
+// spawning never touches the heap.
+class ParticlePool {
+public:
+    explicit ParticlePool(std::size_t capacity)
+        : capacity_(capacity),
+          px_(capacity), py_(capacity), pz_(capacity),
+          dx_(capacity), dy_(capacity), dz_(capacity),
+          speed_(capacity), life_(capacity), length_(capacity), color_(capacity) {}
+
+    // direction should be unit length; the drawn segment runs `length` along it.
+    // False (and counted) when the pool is full.
+    bool spawn(const glm::vec3& position, const glm::vec3& direction, float speed, float lifetime,
+               float length, const glm::vec4& color) {
+        if (count_ == capacity_) { ++dropped_; return false; }
+        const std::size_t i = count_++;
+        px_[i] = position.x; py_[i] = position.y; pz_[i] = position.z;
+        dx_[i] = direction.x; dy_[i] = direction.y; dz_[i] = direction.z;
+        speed_[i] = speed;
+        life_[i] = lifetime;
+        length_[i] = length;
+        color_[i] = color;
+        return true;
+    }
+
+    void update(float dt) {
+        integrate(count_, dt, px_.data(), py_.data(), pz_.data(),
+                  dx_.data(), dy_.data(), dz_.data(), speed_.data(), life_.data());
+        for (std::size_t i = 0; i < count_; ) {
+            if (life_[i] <= 0.0f) remove(i); // i now holds the former last particle
+            else ++i;
+        }
+    }
+
+    void clear() { count_ = 0; }
+
+    std::size_t size() const { return count_; }
+    std::size_t capacity() const { return capacity_; }
+    uint64_t dropped() const { return dropped_; }
+
+    glm::vec3 position(std::size_t i) const { return { px_[i], py_[i], pz_[i] }; }
+    glm::vec3 tail(std::size_t i) const { return position(i) + glm::vec3(dx_[i], dy_[i], dz_[i]) * length_[i]; }
+    const glm::vec4& color(std::size_t i) const { return color_[i]; }
+
+private:
+    // restrict parameters (not locals, which GCC ignores) let the loop vectorize without alias checks
+    static void integrate(std::size_t n, float dt,
+                          float* __restrict px, float* __restrict py, float* __restrict pz,
+                          const float* __restrict dx, const float* __restrict dy, const float* __restrict dz,
+                          const float* __restrict speed, float* __restrict life) {
+        for (std::size_t i = 0; i < n; ++i) {
+            const float step = speed[i] * dt;
+            px[i] += dx[i] * step;
+            py[i] += dy[i] * step;
+            pz[i] += dz[i] * step;
+            life[i] -= dt;
+        }
+    }
+
+    void remove(std::size_t i) {
+        const std::size_t last = --count_;
+        px_[i] = px_[last]; py_[i] = py_[last]; pz_[i] = pz_[last];
+        dx_[i] = dx_[last]; dy_[i] = dy_[last]; dz_[i] = dz_[last];
+        speed_[i] = speed_[last];
+        life_[i] = life_[last];
+        length_[i] = length_[last];
+        color_[i] = color_[last];
+    }
+
+    const std::size_t capacity_;
+    std::size_t count_ = 0;
+    uint64_t dropped_ = 0;
+    std::vector<float> px_, py_, pz_;
+    std::vector<float> dx_, dy_, dz_;
+    std::vector<float> speed_;
+    std::vector<float> life_;
+    std::vector<float> length_;
+    std::vector<glm::vec4> color_;
+};
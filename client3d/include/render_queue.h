@@ -0,0 +1,192 @@
+#pragma once
+
+// Deferred, state-sorted draw submission.
+//
+// Draws are collected for the frame as DrawCalls, each with a 64-bit sort key
+//
+//   63..60 pass   59..52 program   51..36 material   35..20 VAO   19..0 depth
+//
+// radix-sorted, and submitted in key order: one pass after another, and within a pass
+// every draw of one program together, every draw of one material together, and so on.
+// Submission only issues the state changes that differ from the previous draw. The
+// program and VAO fields are the GL names truncated to 8 and 16 bits (GL hands out
+// small sequential names), the material field a hash of its address. A collision in
+// any of them costs only a lost grouping; elision compares the real objects.
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "instancing.h"
+#include "mesh.h"
+#include "shader.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// In submission order. Each pass sets its own fixed-function state.
+enum class RenderPass : uint8_t {
+    Opaque = 0,    // filled, depth tested
+    Wireframe = 1, // glPolygonMode GL_LINE (debug hitboxes)
+    Lines = 2,     // GL_LINES with constant instance attributes and wide lines (tracers)
+};
+
+struct DrawCall {
+    RenderPass pass = RenderPass::Opaque;
+    Shader* shader = nullptr;
+    const Material* material = nullptr; // null for programs without material uniforms
+    GLuint vao = 0;
+    GLenum primitive = GL_TRIANGLES;
+    bool indexed = false;   // GL_UNSIGNED_INT indices from the VAO's element buffer
+    std::size_t first = 0;  // first index or vertex
+    GLsizei count = 0;      // indices or vertices
+    bool instanced = false; // glDraw*Instanced, attributes from the batch attached to vao
+    GLsizei instances = 1;
+};
+
+struct RenderStats {
+    uint32_t draws = 0;
+    uint32_t programs = 0;  // glUseProgram calls
+    uint32_t materials = 0; // material binds
+    uint32_t vaos = 0;      // glBindVertexArray calls
+    uint32_t passes = 0;
+};
+
+class RenderQueue {
+public:
+    // depth passed to add() is clamped to [0, max_depth] and orders draws front to back
+    // within otherwise equal state
+    explicit RenderQueue(float max_depth = 100.0f) : max_depth_(max_depth) {}
+
+    void clear() { items_.clear(); }
+    std::size_t size() const { return items_.size(); }
+
+    // Draws with nothing to draw (no indices, or an empty instance batch) are dropped
+    void add(const DrawCall& draw, float depth = 0.0f) {
+        if (draw.count <= 0 || (draw.instanced && draw.instances <= 0)) return;
+        items_.push_back({ make_key(draw, depth), draw });
+    }
+
+    // One LOD of a mesh, instanced from the batch attached to its lodVAOs[lod]
+    void addMesh(const Mesh& mesh, Shader& shader, std::size_t lod, GLsizei instances, float depth = 0.0f) {
+        lod = std::min(lod, mesh.lods.size() - 1);
+        DrawCall draw;
+        draw.shader = &shader;
+        draw.material = &mesh.material;
+        draw.vao = mesh.lodVAOs[lod];
+        draw.indexed = true;
+        draw.first = mesh.lods[lod].first;
+        draw.count = static_cast<GLsizei>(mesh.lods[lod].count);
+        draw.instanced = true;
+        draw.instances = instances;
+        add(draw, depth);
+    }
+
+    // Sorts and issues every queued draw, then clears the queue. Leaves the GL state
+    // as the original immediate code did: filled polygons, 1px lines, no VAO bound.
+    RenderStats submit() {
+        RenderStats stats;
+        sort();
+        int pass = -1;
+        Shader* shader = nullptr;
+        const Material* material = nullptr;
+        GLuint vao = 0;
+        bool vao_bound = false;
+        for (uint32_t index : order_) {
+            const DrawCall& draw = items_[index].draw;
+            if (static_cast<int>(draw.pass) != pass) {
+                pass = static_cast<int>(draw.pass);
+                begin_pass(draw.pass);
+                stats.passes++;
+            }
+            if (draw.shader != shader) {
+                shader = draw.shader;
+                shader->use();
+                material = nullptr; // uniforms are per program: the next material must be set again
+                stats.programs++;
+            }
+            if (draw.material && draw.material != material) {
+                material = draw.material;
+                material->bind(*draw.shader);
+                stats.materials++;
+            }
+            if (!vao_bound || draw.vao != vao) {
+                vao = draw.vao;
+                vao_bound = true;
+                glBindVertexArray(vao);
+                stats.vaos++;
+            }
+            issue(draw);
+            stats.draws++;
+        }
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        glLineWidth(1.0f);
+        items_.clear();
+        return stats;
+    }
+
+private:
+    struct Item {
+        uint64_t key;
+        DrawCall draw;
+    };
+
+    static uint64_t hash_bits(uint64_t value, int bits) {
+        value *= 0x9E3779B97F4A7C15ull; // Fibonacci hashing: the high bits mix every input bit
+        return value >> (64 - bits);
+    }
+
+    uint64_t make_key(const DrawCall& draw, float depth) const {
+        const float t = std::clamp(depth / max_depth_, 0.0f, 1.0f);
+        const uint64_t depth_bits = static_cast<uint64_t>(t * static_cast<float>((1u << 20) - 1));
+        const uint64_t program = draw.shader ? (draw.shader->ID & 0xffu) : 0u;
+        const uint64_t material = draw.material ? hash_bits(reinterpret_cast<uintptr_t>(draw.material), 16) : 0u;
+        return (static_cast<uint64_t>(draw.pass) << 60) | (program << 52) | (material << 36)
+             | ((static_cast<uint64_t>(draw.vao) & 0xffffu) << 20) | depth_bits;
+    }
+
+    // LSD radix sort of item indices by key, 8 bits at a time; digits that are the same
+    // in every key (most of the high ones, in practice) are skipped
+    void sort() {
+        const std::size_t n = items_.size();
+        order_.resize(n);
+        scratch_.resize(n);
+        for (std::size_t i = 0; i < n; i++) order_[i] = static_cast<uint32_t>(i);
+        for (int shift = 0; shift < 64; shift += 8) {
+            std::size_t counts[256] = {};
+            for (const Item& item : items_) counts[(item.key >> shift) & 0xffu]++;
+            if (n == 0 || counts[(items_[0].key >> shift) & 0xffu] == n) continue;
+            std::size_t offsets[256];
+            std::size_t sum = 0;
+            for (int d = 0; d < 256; d++) { offsets[d] = sum; sum += counts[d]; }
+            for (uint32_t index : order_) scratch_[offsets[(items_[index].key >> shift) & 0xffu]++] = index;
+            order_.swap(scratch_);
+        }
+    }
+
+    static void begin_pass(RenderPass pass) {
+        glPolygonMode(GL_FRONT_AND_BACK, pass == RenderPass::Wireframe ? GL_LINE : GL_FILL);
+        glLineWidth(pass == RenderPass::Lines ? 3.0f : 1.0f);
+        // line vertices are in world space and carry their color
+        if (pass == RenderPass::Lines) set_constant_instance(glm::mat4(1.0f), glm::vec4(1.0f));
+    }
+
+    static void issue(const DrawCall& draw) {
+        if (draw.indexed) {
+            const void* offset = reinterpret_cast<const void*>(draw.first * sizeof(unsigned int));
+            if (draw.instanced) glDrawElementsInstanced(draw.primitive, draw.count, GL_UNSIGNED_INT, offset, draw.instances);
+            else glDrawElements(draw.primitive, draw.count, GL_UNSIGNED_INT, offset);
+        } else {
+            const GLint first = static_cast<GLint>(draw.first);
+            if (draw.instanced) glDrawArraysInstanced(draw.primitive, first, draw.count, draw.instances);
+            else glDrawArrays(draw.primitive, first, draw.count);
+        }
+    }
+
+    float max_depth_;
+    std::vector<Item> items_;
+    std::vector<uint32_t> order_, scratch_;
+};
@@ -3,10 +3,33 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <utility>
+#include <vector>
+
+// FNV-1a over a uniform name; constexpr so literal names hash at compile time
+constexpr uint32_t uniform_hash(std::string_view name) {
+    uint32_t hash = 2166136261u;
+    for (char c : name) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// A uniform name as its hash. Implicit from string literals so setX("view", ...) still
+// reads naturally; hot paths keep them in constexpr variables so no hashing is left at run time.
+struct UniformId {
+    uint32_t hash;
+    constexpr UniformId(const char* name) : hash(uniform_hash(name)) {}
+    constexpr UniformId(std::string_view name) : hash(uniform_hash(name)) {}
+};
 
 class Shader {
 public:
@@ -64,50 +87,92 @@ public:
         // delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(vertex);
         glDeleteShader(fragment);
+        // 3. look up every active uniform once, so the setters never ask the driver
+        reflectUniforms();
     }
     // activate the shader
     void use() {
         glUseProgram(ID);
     }
+    // location of an active uniform from the table built at link time; -1 (which
+    // glUniform* ignores) if the program has no such uniform
+    GLint location(UniformId id) const {
+        auto it = std::lower_bound(locations.begin(), locations.end(), id.hash,
+                                   [](const std::pair<uint32_t, GLint>& e, uint32_t h) { return e.first < h; });
+        return (it != locations.end() && it->first == id.hash) ? it->second : -1;
+    }
+    // connect a uniform block to a buffer binding point (GLSL 330 has no layout(binding))
+    void bindUniformBlock(const char* block, GLuint binding) const {
+        GLuint index = glGetUniformBlockIndex(ID, block);
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, index, binding);
+    }
     // utility uniform functions
-    void setBool(const std::string& name, bool value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    void setBool(UniformId name, bool value) const {
+        glUniform1i(location(name), (int)value);
     }
-    void setInt(const std::string& name, int value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    void setInt(UniformId name, int value) const {
+        glUniform1i(location(name), value);
     }
-    void setFloat(const std::string& name, float value) const {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    void setFloat(UniformId name, float value) const {
+        glUniform1f(location(name), value);
     }
-    void setVec2(const std::string& name, const glm::vec2& value) const {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    void setVec2(UniformId name, const glm::vec2& value) const {
+        glUniform2fv(location(name), 1, &value[0]);
     }
-    void setVec2(const std::string& name, float x, float y) const {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+    void setVec2(UniformId name, float x, float y) const {
+        glUniform2f(location(name), x, y);
     }
-    void setVec3(const std::string& name, const glm::vec3& value) const {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    void setVec3(UniformId name, const glm::vec3& value) const {
+        glUniform3fv(location(name), 1, &value[0]);
     }
-    void setVec3(const std::string& name, float x, float y, float z) const {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+    void setVec3(UniformId name, float x, float y, float z) const {
+        glUniform3f(location(name), x, y, z);
     }
-    void setVec4(const std::string& name, const glm::vec4& value) const {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    void setVec4(UniformId name, const glm::vec4& value) const {
+        glUniform4fv(location(name), 1, &value[0]);
     }
-    void setVec4(const std::string& name, float x, float y, float z, float w) const {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+    void setVec4(UniformId name, float x, float y, float z, float w) const {
+        glUniform4f(location(name), x, y, z, w);
     }
-    void setMat2(const std::string& name, const glm::mat2& mat) const {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    void setMat2(UniformId name, const glm::mat2& mat) const {
+        glUniformMatrix2fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
-    void setMat3(const std::string& name, const glm::mat3& mat) const {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    void setMat3(UniformId name, const glm::mat3& mat) const {
+        glUniformMatrix3fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
-    void setMat4(const std::string& name, const glm::mat4& mat) const {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    void setMat4(UniformId name, const glm::mat4& mat) const {
+        glUniformMatrix4fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
+    // (name hash, location), sorted by hash
+    std::vector<std::pair<uint32_t, GLint>> locations;
+
+    void reflectUniforms() {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::string name(std::max(maxLength, 1), '\0');
+        for (GLint i = 0; i < count; i++) {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, i, maxLength, &length, &size, &type, &name[0]);
+            std::string_view view(name.data(), length);
+            GLint loc = glGetUniformLocation(ID, name.c_str());
+            if (loc < 0) continue; // member of a uniform block
+            locations.emplace_back(uniform_hash(view), loc);
+            // arrays are reported as "name[0]"; make plain "name" work too
+            if (view.size() > 3 && view.substr(view.size() - 3) == "[0]")
+                locations.emplace_back(uniform_hash(view.substr(0, view.size() - 3)), loc);
+        }
+        std::sort(locations.begin(), locations.end());
+        for (size_t i = 1; i < locations.size(); i++)
+            if (locations[i].first == locations[i - 1].first && locations[i].second != locations[i - 1].second)
+                std::cout << "ERROR::SHADER::UNIFORM_HASH_COLLISION in program " << ID << std::endl;
+    }
+
     // utility function for checking shader compilation/linking errors.
     void checkCompileErrors(GLuint shader, std::string type) {
         GLint success;
@@ -0,0 +1,141 @@
+#pragma once
+
+// Vertex layouts a mesh can be stored in on the GPU. Meshes are built and cooked as
+// full-float Vertex and encoded into one of the compact formats at cook time:
+//
+//   Float      Vertex           32 bytes  float position, normal, uv
+//   Packed     PackedVertex     20 bytes  float position, 10:10:10:2 snorm normal, half uv
+//   Quantized  QuantizedVertex  16 bytes  unorm16 position within the mesh bounds, rest as Packed
+//
+// Quantized positions decode as aPos * positionScale + positionOffset in the vertex shader.
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+struct Vertex {
+    glm::vec3 Position;
+    glm::vec3 Normal;
+    glm::vec2 TexCoords;
+};
+
+enum class VertexFormat : uint32_t { Float = 0, Packed = 1, Quantized = 2 };
+
+// What models are cooked to unless asked otherwise
+constexpr VertexFormat kDefaultVertexFormat = VertexFormat::Quantized;
+
+struct PackedVertex {
+    float Position[3];
+    uint32_t Normal;       // GL_INT_2_10_10_10_REV, normalized
+    uint16_t TexCoords[2]; // GL_HALF_FLOAT
+};
+
+struct QuantizedVertex {
+    uint16_t Position[4];  // GL_UNSIGNED_SHORT, normalized; [3] is padding
+    uint32_t Normal;
+    uint16_t TexCoords[2];
+};
+
+static_assert(sizeof(Vertex) == 32 && sizeof(PackedVertex) == 20 && sizeof(QuantizedVertex) == 16,
+              "vertex layouts are part of the mesh cache format");
+
+inline std::size_t vertex_stride(VertexFormat format) {
+    switch (format) {
+        case VertexFormat::Packed: return sizeof(PackedVertex);
+        case VertexFormat::Quantized: return sizeof(QuantizedVertex);
+        default: return sizeof(Vertex);
+    }
+}
+
+// IEEE half, round to nearest even; overflow goes to infinity, tiny values to (signed) zero or subnormals
+inline uint16_t float_to_half(float value) {
+    uint32_t f;
+    std::memcpy(&f, &value, sizeof(f));
+    const uint32_t sign = (f >> 16) & 0x8000u;
+    const int32_t exponent = static_cast<int32_t>((f >> 23) & 0xffu) - 127 + 15;
+    uint32_t mantissa = f & 0x7fffffu;
+    if (((f >> 23) & 0xffu) == 0xffu) return static_cast<uint16_t>(sign | 0x7c00u | (mantissa ? 0x200u : 0u)); // inf / nan
+    if (exponent >= 31) return static_cast<uint16_t>(sign | 0x7c00u);
+    if (exponent <= 0) {
+        if (exponent < -10) return static_cast<uint16_t>(sign);
+        mantissa |= 0x800000u;
+        const uint32_t shift = static_cast<uint32_t>(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        const uint32_t rest = mantissa & ((1u << shift) - 1), halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1u))) half++;
+        return static_cast<uint16_t>(sign | half);
+    }
+    uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    const uint32_t rest = mantissa & 0x1fffu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) half++; // may carry into the exponent, which is correct
+    return static_cast<uint16_t>(sign | half);
+}
+
+// xyz as 10-bit snorm in the low bits, w (2 bits) left zero
+inline uint32_t pack_normal(const glm::vec3& n) {
+    auto snorm10 = [](float v) {
+        const int32_t q = static_cast<int32_t>(std::lround(std::clamp(v, -1.0f, 1.0f) * 511.0f));
+        return static_cast<uint32_t>(q) & 0x3ffu;
+    };
+    return snorm10(n.x) | (snorm10(n.y) << 10) | (snorm10(n.z) << 20);
+}
+
+struct EncodedVertices {
+    VertexFormat format = VertexFormat::Float;
+    std::vector<uint8_t> bytes;
+    glm::vec3 positionScale{ 1.0f };
+    glm::vec3 positionOffset{ 0.0f };
+    glm::vec3 boundsMin{ 0.0f }; // object-space bounds of the positions, for culling
+    glm::vec3 boundsMax{ 0.0f };
+};
+
+inline EncodedVertices encode_vertices(const std::vector<Vertex>& vertices, VertexFormat format) {
+    EncodedVertices out;
+    out.format = format;
+    out.bytes.resize(vertices.size() * vertex_stride(format));
+    if (!vertices.empty()) {
+        out.boundsMin = out.boundsMax = vertices[0].Position;
+        for (const Vertex& v : vertices) {
+            out.boundsMin = glm::min(out.boundsMin, v.Position);
+            out.boundsMax = glm::max(out.boundsMax, v.Position);
+        }
+    }
+    if (format == VertexFormat::Float) {
+        if (!vertices.empty()) std::memcpy(out.bytes.data(), vertices.data(), out.bytes.size());
+        return out;
+    }
+
+    if (format == VertexFormat::Quantized && !vertices.empty()) {
+        out.positionOffset = out.boundsMin;
+        out.positionScale = out.boundsMax - out.boundsMin;
+        for (int i = 0; i < 3; i++)
+            if (out.positionScale[i] <= 0.0f) out.positionScale[i] = 1.0f; // flat axis: any scale decodes to lo
+    }
+
+    uint8_t* dst = out.bytes.data();
+    for (const Vertex& v : vertices) {
+        const uint32_t normal = pack_normal(v.Normal);
+        const uint16_t uv[2] = { float_to_half(v.TexCoords.x), float_to_half(v.TexCoords.y) };
+        if (format == VertexFormat::Packed) {
+            PackedVertex p{ { v.Position.x, v.Position.y, v.Position.z }, normal, { uv[0], uv[1] } };
+            std::memcpy(dst, &p, sizeof(p));
+        } else {
+            QuantizedVertex q{};
+            for (int i = 0; i < 3; i++) {
+                const float t = (v.Position[i] - out.positionOffset[i]) / out.positionScale[i];
+                q.Position[i] = static_cast<uint16_t>(std::lround(std::clamp(t, 0.0f, 1.0f) * 65535.0f));
+            }
+            q.Normal = normal;
+            q.TexCoords[0] = uv[0];
+            q.TexCoords[1] = uv[1];
+            std::memcpy(dst, &q, sizeof(q));
+        }
+        dst += vertex_stride(format);
+    }
+    return out;
+}
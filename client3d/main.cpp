@@ -7,24 +7,39 @@
 #include "include/shader.h"
 #include "include/camera.h"
 #include "include/model.h"
+#include "include/asset_manager.h"
+#include "include/culling.h"
+#include "include/lod.h"
+#include "include/interpolation.h"
+#include "include/instancing.h"
+#include "include/frame_uniforms.h"
+#include "include/line_batch.h"
+#include "include/render_queue.h"
+#include "include/particles.h"
 #include <iostream>
+#include <fstream>
 #include <thread>
+#include <atomic>
 #include <map>
 #include <cstdio>
 #include <vector>
-#include <list>
 #include <string>
 #include "NetworkClient.h"
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
 #include <SFML/Audio.hpp>
+#include "../shared/input_frames.h"
+#include "../shared/log.h"
+#include "../shared/spsc_ring.h"
+#include "../shared/trace.h"
+#include "../shared/triple_buffer.h"
 
 // Function prototypes
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
-void processInput(GLFWwindow *window, PlayerInputData& input, NetworkClient& client, sf::Sound& shootSound, const GameState& gameState);
+void toggleTraceCapture(GLFWwindow* window);
 
 // Constants and globals
 const unsigned int SCR_WIDTH = 1280;
@@ -35,11 +50,8 @@ float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
 bool show_cursor = false;
 bool chat_input_active = false;
-float deltaTime = 0.0f;
-float lastFrame = 0.0f;
 
 // Struct definitions
-struct AABB { glm::vec3 min; glm::vec3 max; };
 struct Player {
     glm::vec3 position;
     glm::quat rotation;
@@ -49,15 +61,64 @@ struct Player {
     int kills;
     int deaths;
     bool is_ready;
+    glm::quat visual_rotation = glm::quat(1, 0, 0, 0);
+    SnapshotBuffer snapshots; // remote players only
 };
 struct StaticObject { glm::vec3 position; glm::vec3 scale; glm::vec3 color; };
-struct Projectile {
-    glm::vec3 position;
-    glm::vec3 direction;
-    float speed = 100.0f;
-    float lifetime = 1.0f;
+constexpr float kProjectileSpeed = 100.0f;
+constexpr float kProjectileLifetime = 1.0f;
+const glm::vec4 kTracerColor(1.0f, 1.0f, 0.0f, 1.0f);
+const glm::vec4 kHitSparkColor(1.0f, 0.4f, 0.1f, 1.0f);
+constexpr std::chrono::microseconds kAssetUploadBudget(2000); // GPU uploads per frame
+constexpr std::chrono::microseconds kSimulationStep(SERVER_TICK_US / 2); // two steps per server tick
+
+// What the render thread draws: the game state as of one simulation step, copied out
+struct PlayerView {
+    uint32_t id;
+    glm::vec3 visual_position;
+    glm::quat visual_rotation;
+    AABB bounding_box;
+    int health;
+    int kills;
+    int deaths;
+    bool is_ready;
+};
+struct TracerSegment { glm::vec3 head; glm::vec3 tail; glm::vec4 color; };
+struct FrameSnapshot {
+    uint32_t my_player_id = 0;
+    glm::vec3 my_visual_position = glm::vec3(0.0f);
+    GameState game_state = GameState::LOBBY;
+    uint32_t winner_id = 0;
+    std::vector<PlayerView> players; // by id
+    std::vector<TracerSegment> tracers;
+    std::vector<std::string> chat_history;
+    uint32_t chat_generation = 0;    // bumped when chat_history changes; copied only then
+    uint64_t hits = 0;               // PlayerHit events so far
+    double interp_delay_ms = 0.0;
+
+    const PlayerView* find(uint32_t id) const {
+        for (const PlayerView& player : players)
+            if (player.id == id) return &player;
+        return nullptr;
+    }
 };
 
+// Render thread -> simulation thread: messages to send (shoot, ready, chat), so that
+// NetworkClient::send keeps a single calling thread
+using OutgoingRequests = SpscRing<GameMessage, 64>;
+
+// Everything the render and simulation threads share; neither ever waits for the other
+struct SimulationChannels {
+    TripleBuffer<FrameSnapshot> frames;
+    TripleBuffer<PlayerInputData> input; // keys held and camera orientation, every frame
+    OutgoingRequests requests;
+    std::atomic<bool> stop{ false };
+};
+
+void processInput(GLFWwindow *window, PlayerInputData& input, OutgoingRequests& requests, sf::Sound& shootSound, GameState gameState);
+bool queueRequest(OutgoingRequests& requests, const GameMessage& msg);
+void runSimulation(NetworkClient& client, SimulationChannels& channels);
+
 int main() {
     // Initialization
     glfwInit();
@@ -78,18 +139,23 @@ int main() {
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 330");
 
-    // Asset Loading
+    // Asset Loading: shaders are small and need the GL context, so they load here;
+    // the model and sounds load in the background and are used once ready()
     Shader ourShader("shaders/1.model_loading.vs", "shaders/1.model_loading.fs");
-    Model ourModel("assets/models/backpack/backpack.obj");
     Shader debugShader("shaders/debug.vs", "shaders/debug.fs");
-    sf::SoundBuffer shootBuffer;
-    if (!shootBuffer.loadFromFile("assets/sounds/shoot.wav")) { std::cerr << "Error: Could not load shoot.wav\n"; }
+    // Per-frame matrices and light live in one uniform buffer shared by both programs
+    FrameUniformBuffer frameUniforms;
+    ourShader.bindUniformBlock(kFrameUniformBlock, kFrameUniformBinding);
+    debugShader.bindUniformBlock(kFrameUniformBlock, kFrameUniformBinding);
+    ourShader.use();
+    ourShader.setFloat("material.shininess", 32.0f);
+    AssetManager assets;
+    auto playerModel = assets.model("assets/models/backpack/backpack.obj");
+    auto shootSoundAsset = assets.sound("assets/sounds/shoot.wav");
+    auto hitSoundAsset = assets.sound("assets/sounds/hit.wav");
+    bool playerModelBound = false, shootSoundBound = false, hitSoundBound = false;
     sf::Sound shootSound;
-    shootSound.setBuffer(shootBuffer);
-    sf::SoundBuffer hitBuffer;
-    if (!hitBuffer.loadFromFile("assets/sounds/hit.wav")) { std::cerr << "Error: Could not load hit.wav\n"; }
     sf::Sound hitSound;
-    hitSound.setBuffer(hitBuffer);
     
     // Vertex Data
     float vertices[] = { -0.5f,-0.5f,-0.5f, 0.5f,-0.5f,-0.5f, 0.5f, 0.5f,-0.5f, 0.5f, 0.5f,-0.5f,-0.5f, 0.5f,-0.5f,-0.5f,-0.5f,-0.5f, -0.5f,-0.5f, 0.5f, 0.5f,-0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f,-0.5f, 0.5f, 0.5f,-0.5f,-0.5f, 0.5f, -0.5f, 0.5f, 0.5f,-0.5f, 0.5f,-0.5f,-0.5f, 0.5f,-0.5f,-0.5f, 0.5f,-0.5f,-0.5f, 0.5f,-0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f,-0.5f, 0.5f,-0.5f,-0.5f,-0.5f,-0.5f,-0.5f,-0.5f,-0.5f, 0.5f, 0.5f,-0.5f, 0.5f, 0.5f, 0.5f,-0.5f, 0.5f, -0.5f,-0.5f,-0.5f, 0.5f,-0.5f,-0.5f, 0.5f,-0.5f, 0.5f, 0.5f,-0.5f, 0.5f,-0.5f,-0.5f, 0.5f,-0.5f,-0.5f,-0.5f, -0.5f, 0.5f,-0.5f, 0.5f, 0.5f,-0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f,-0.5f, 0.5f, 0.5f,-0.5f, 0.5f,-0.5f };
@@ -99,8 +165,15 @@ int main() {
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0); glBindVertexArray(0);
-    unsigned int projectileVAO, projectileVBO;
-    glGenVertexArrays(1, &projectileVAO); glGenBuffers(1, &projectileVBO);
+    // Same cube for the wireframe boxes; a VAO per instance batch
+    unsigned int boxVAO;
+    glGenVertexArrays(1, &boxVAO);
+    glBindVertexArray(boxVAO); glBindBuffer(GL_ARRAY_BUFFER, worldVBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0); glBindVertexArray(0);
+    LineBatch tracers;
+    // Plain float cube: identity dequantization, no textures
+    const Material cubeMaterial;
 
     // Game World
     std::vector<StaticObject> static_objects;
@@ -109,52 +182,382 @@ int main() {
     static_objects.push_back({ {4.0f, 0.5f, 5.0f}, {2.0f, 2.0f, 2.0f}, {0.2f, 0.2f, 0.8f} });
     static_objects.push_back({ {0.0f, 0.0f, 8.5f}, {4.0f, 1.0f, 1.0f}, {0.8f, 0.8f, 0.2f} });
 
+    // Instanced rendering: one draw per mesh type, refilled every frame with what the
+    // frustum test keeps. The world never moves, so its bounds go into a BVH built once.
+    InstanceBatch worldInstances, boxInstances;
+    InstanceBatch playerInstances[kMeshLodCount]; // one batch per LOD of the player model
+    std::vector<float> playerLodErrors;
+    worldInstances.attach(worldVAO);
+    boxInstances.attach(boxVAO);
+    const AABB kUnitCube{ glm::vec3(-0.5f), glm::vec3(0.5f) };
+    std::vector<glm::mat4> static_transforms;
+    SceneBvh world_bvh;
+    for (const auto& object : static_objects) {
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, object.position);
+        model = glm::scale(model, object.scale);
+        world_bvh.add(transform_aabb(kUnitCube, model), static_cast<uint32_t>(static_transforms.size()));
+        static_transforms.push_back(model);
+    }
+    world_bvh.build();
+    std::vector<uint32_t> visible_objects;
+    CullStats world_cull, player_cull; // last rendered frame, for the HUD
+    uint32_t players_per_lod[kMeshLodCount] = {};
+    RenderQueue renderQueue;
+    RenderStats render_stats;
+
     // Network
     boost::asio::io_context io_context;
     NetworkClient client(io_context);
     client.connect("127.0.0.1", std::to_string(TCP_PORT));
-    std::thread network_thread([&io_context](){ io_context.run(); });
+    std::thread network_thread([&io_context](){ trace::set_thread_name("network"); io_context.run(); });
+    trace::set_thread_name("main");
+
+    // Game state is owned by the simulation thread; this one draws its latest snapshot
+    SimulationChannels simulation;
+    std::thread simulation_thread([&client, &simulation]() { runSimulation(client, simulation); });
+    uint64_t hits_heard = 0;
+    std::map<uint32_t, std::size_t> player_lods; // model LOD each player was drawn at last frame
+    char chat_input_buf[MAX_CHAT_MESSAGE_LENGTH] = "";
+
+    // Game Loop
+    while (!glfwWindowShouldClose(window)) {
+        TRACE_SCOPE("frame");
+        toggleTraceCapture(window);
+        {
+            TRACE_SCOPE("assets");
+            assets.pump(kAssetUploadBudget);
+            if (!playerModelBound && playerModel->ready()) {
+                const std::size_t lods = std::min(playerModel->model.lodCount(), kMeshLodCount);
+                for (const auto& mesh : playerModel->model.meshes)
+                    for (std::size_t lod = 0; lod < lods; lod++) playerInstances[lod].attach(mesh.lodVAOs[lod]);
+                for (std::size_t lod = 0; lod < lods; lod++) playerLodErrors.push_back(playerModel->model.lodError(lod));
+                playerModelBound = true;
+            }
+            if (!shootSoundBound && shootSoundAsset->ready()) { shootSound.setBuffer(shootSoundAsset->buffer); shootSoundBound = true; }
+            if (!hitSoundBound && hitSoundAsset->ready()) { hitSound.setBuffer(hitSoundAsset->buffer); hitSoundBound = true; }
+        }
+        simulation.frames.consume(); // the previous snapshot again if no step has finished since
+        const FrameSnapshot& world = simulation.frames.read_slot();
+        if (world.hits != hits_heard) { hits_heard = world.hits; hitSound.play(); }
+        PlayerInputData current_input = {};
+        processInput(window, current_input, simulation.requests, shootSound, world.game_state);
+        current_input.rotation = camera.getRotationQuat();
+        simulation.input.write_slot() = current_input;
+        simulation.input.publish();
+
+        glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        
+        ImGui_ImplOpenGL3_NewFrame(); ImGui_ImplGlfw_NewFrame(); ImGui::NewFrame();
+
+        {
+            // Network HUD: RTT from Ping/Pong, estimated server tick, interpolation delay
+            const auto lat = client.latency();
+            ImGui::SetNextWindowPos(ImVec2(SCR_WIDTH - 10.0f, SCR_HEIGHT - 10.0f), ImGuiCond_Always, ImVec2(1, 1));
+            ImGui::SetNextWindowBgAlpha(0.35f);
+            ImGui::Begin("Network", NULL, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoInputs);
+            if (lat.valid) ImGui::Text("RTT %.1f ms  jitter %.1f ms", lat.rtt_ms, lat.jitter_ms);
+            else ImGui::Text("RTT --");
+            if (client.server_clock_synced()) ImGui::Text("Server tick %.0f", client.estimated_server_tick());
+            ImGui::Text("Interp delay %.1f ms", world.interp_delay_ms);
+            ImGui::End();
+
+            // Render HUD: what survived frustum culling last frame
+            ImGui::SetNextWindowPos(ImVec2(10.0f, 10.0f), ImGuiCond_Always);
+            ImGui::SetNextWindowBgAlpha(0.35f);
+            ImGui::Begin("Render", NULL, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoInputs);
+            ImGui::Text("World %u/%u visible  (%u BVH nodes)", world_cull.visible, world_cull.objects, world_cull.nodes_visited);
+            ImGui::Text("Players %u/%u visible  LODs %u/%u/%u/%u", player_cull.visible, player_cull.objects,
+                        players_per_lod[0], players_per_lod[1], players_per_lod[2], players_per_lod[3]);
+            ImGui::Text("Draws %u  programs %u  materials %u  VAOs %u", render_stats.draws, render_stats.programs,
+                        render_stats.materials, render_stats.vaos);
+            ImGui::End();
+        }
+        
+        if (world.game_state == GameState::LOBBY) {
+            show_cursor = true;
+            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+            ImGui::SetNextWindowPos(ImVec2(SCR_WIDTH * 0.5f, SCR_HEIGHT * 0.5f), ImGuiCond_Always, ImVec2(0.5,0.5));
+            ImGui::SetNextWindowSize(ImVec2(400,300), ImGuiCond_Always);
+            ImGui::Begin("Lobby", NULL, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
+            ImGui::Text("Waiting for players (2 needed to start)...");
+            ImGui::Separator();
+            if (ImGui::BeginTable("lobby_players", 2, ImGuiTableFlags_Borders)) {
+                ImGui::TableSetupColumn("Player ID"); ImGui::TableSetupColumn("Status");
+                ImGui::TableHeadersRow();
+                for(const PlayerView& player : world.players){
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0); ImGui::Text("%u", player.id);
+                    ImGui::TableSetColumnIndex(1);
+                    if(player.is_ready) { ImGui::TextColored(ImVec4(0,1,0,1), "Ready"); } 
+                    else { ImGui::Text("Not Ready"); }
+                }
+                ImGui::EndTable();
+            }
+            ImGui::Separator();
+            const PlayerView* me = world.find(world.my_player_id);
+            if (me && !me->is_ready) {
+            if (ImGui::Button("Ready Up", ImVec2(-1, 40))) {
+                GameMessage ready_msg;
+                ready_msg.type = MessageType::ClientReady;
+                ready_msg.setData(ClientReadyData{});
+                queueRequest(simulation.requests, ready_msg); // on failure the button stays up
+                }
+                ImGui::Text("Waiting for other players to ready up...");
+            }
+
+            ImGui::End();
+        } else {
+            if (!chat_input_active) {
+                show_cursor = false;
+                glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+            }
+            TRACE_SCOPE("render");
+            if(world.my_player_id != 0 && world.find(world.my_player_id)){
+                glm::vec3 player_visual_pos = world.my_visual_position;
+                float distance_from_player = 5.0f;
+                camera.Position = player_visual_pos - (camera.Front * distance_from_player) + glm::vec3(0.0, 1.5, 0.0);
+            }
+            glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+            glm::mat4 view = camera.GetViewMatrix();
+            FrameUniforms frame;
+            frame.projection = projection;
+            frame.view = view;
+            frame.viewPos = glm::vec4(camera.Position, 1.0f);
+            frame.lightPosition = glm::vec4(0.0f, 10.0f, 10.0f, 1.0f);
+            frame.lightAmbient = glm::vec4(0.2f, 0.2f, 0.2f, 0.0f);
+            frame.lightDiffuse = glm::vec4(0.8f, 0.8f, 0.8f, 0.0f);
+            frame.lightSpecular = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+            frameUniforms.update(frame);
+            const Frustum frustum(projection * view);
+
+            world_cull = {};
+            visible_objects.clear();
+            world_bvh.cull(frustum, visible_objects, world_cull);
+            worldInstances.clear();
+            for (uint32_t index : visible_objects)
+                worldInstances.add(static_transforms[index], glm::vec4(static_objects[index].color, 1.0f));
+            worldInstances.upload();
+            // Everything below is queued, sorted by state and drawn in one go at the end
+            renderQueue.clear();
+            DrawCall cubes;
+            cubes.shader = &ourShader;
+            cubes.material = &cubeMaterial;
+            cubes.vao = worldVAO;
+            cubes.count = 36;
+            cubes.instanced = true;
+            cubes.instances = worldInstances.count();
+            renderQueue.add(cubes);
+
+            // Players move every frame, so they are tested directly rather than through a tree:
+            // the model's bounds under its transform, joined with the hitbox drawn around it.
+            // Visible ones go to the batch of the LOD their on-screen error allows.
+            player_cull = {};
+            for (auto& count : players_per_lod) count = 0;
+            for (auto& batch : playerInstances) batch.clear();
+            boxInstances.clear();
+            for (const PlayerView& state : world.players) {
+                if (state.health <= 0) continue;
+                glm::mat4 model = glm::mat4(1.0f);
+                if (state.id == world.my_player_id) {
+                    model = glm::translate(model, world.my_visual_position);
+                    model = model * glm::mat4_cast(camera.getRotationQuat());
+                } else {
+                    model = glm::translate(model, state.visual_position);
+                    model = model * glm::mat4_cast(state.visual_rotation);
+                }
+                AABB bounds = state.bounding_box;
+                if (playerModelBound) bounds = merge(bounds, transform_aabb(playerModel->model.bounds, model));
+                player_cull.objects++;
+                if (!frustum.intersects(bounds)) continue;
+                player_cull.visible++;
+                const float distance = glm::length((bounds.min + bounds.max) * 0.5f - camera.Position);
+                std::size_t& lod = player_lods[state.id];
+                lod = select_lod(playerLodErrors, pixels_per_unit(distance, glm::radians(camera.Zoom), (float)SCR_HEIGHT), lod);
+                playerInstances[lod].add(model);
+                players_per_lod[lod]++;
+
+                glm::vec3 size = state.bounding_box.max - state.bounding_box.min;
+                glm::vec3 center = state.bounding_box.min + size * 0.5f;
+                glm::mat4 box = glm::mat4(1.0f);
+                box = glm::translate(box, center);
+                box = glm::scale(box, size);
+                boxInstances.add(box, glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+            }
+            for (auto it = player_lods.begin(); it != player_lods.end();) {
+                if (world.find(it->first)) ++it;
+                else it = player_lods.erase(it); // left the game
+            }
+            boxInstances.upload();
+            for (std::size_t lod = 0; lod < kMeshLodCount; lod++) {
+                playerInstances[lod].upload();
+                if (!playerModelBound) continue;
+                for (const Mesh& mesh : playerModel->model.meshes)
+                    renderQueue.addMesh(mesh, ourShader, lod, playerInstances[lod].count());
+            }
+
+            DrawCall boxes;
+            boxes.pass = RenderPass::Wireframe;
+            boxes.shader = &debugShader;
+            boxes.vao = boxVAO;
+            boxes.count = 36;
+            boxes.instanced = true;
+            boxes.instances = boxInstances.count();
+            renderQueue.add(boxes);
+
+            // All tracers in one draw; vertices carry their color, the transform is constant
+            tracers.begin();
+            for (const TracerSegment& segment : world.tracers)
+                tracers.add(segment.head, segment.tail, segment.color);
+            tracers.end();
+            DrawCall lines;
+            lines.pass = RenderPass::Lines;
+            lines.shader = &debugShader;
+            lines.vao = tracers.vao();
+            lines.primitive = GL_LINES;
+            lines.first = static_cast<std::size_t>(tracers.first_vertex());
+            lines.count = tracers.vertex_count();
+            renderQueue.add(lines);
+
+            render_stats = renderQueue.submit();
+        }
+        {
+            TRACE_SCOPE("imgui");
+            ImGui::SetNextWindowPos(ImVec2(SCR_WIDTH - 260, 10), ImGuiCond_Always);
+            ImGui::SetNextWindowSize(ImVec2(250, 150), ImGuiCond_Always);
+            ImGui::Begin("Scoreboard", NULL, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
+            if (ImGui::BeginTable("scores", 3, ImGuiTableFlags_Borders)) {
+                ImGui::TableSetupColumn("Player ID"); ImGui::TableSetupColumn("Kills"); ImGui::TableSetupColumn("Deaths");
+                ImGui::TableHeadersRow();
+                for(const PlayerView& player : world.players) {
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0); ImGui::Text("%u", player.id);
+                    ImGui::TableSetColumnIndex(1); ImGui::Text("%d", player.kills);
+                    ImGui::TableSetColumnIndex(2); ImGui::Text("%d", player.deaths);
+                }
+                ImGui::EndTable();
+            }
+            ImGui::End();
+            ImGui::SetNextWindowPos(ImVec2(10, SCR_HEIGHT - 160), ImGuiCond_Always);
+            ImGui::SetNextWindowSize(ImVec2(400, 150), ImGuiCond_Always);
+            ImGui::Begin("Chat", NULL, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
+            ImGui::BeginChild("ChatHistory", ImVec2(0, -ImGui::GetFrameHeightWithSpacing()));
+            for(const auto& msg : world.chat_history){ ImGui::TextUnformatted(msg.c_str()); }
+            ImGui::EndChild();
+            ImGui::PushItemWidth(-1);
+            if(chat_input_active) ImGui::SetKeyboardFocusHere();
+            if(ImGui::InputText("##chat", chat_input_buf, MAX_CHAT_MESSAGE_LENGTH, ImGuiInputTextFlags_EnterReturnsTrue)){
+                if(strlen(chat_input_buf) > 0){
+                    GameMessage msg;
+                    msg.type = MessageType::ChatMessage;
+                    ChatMessageData chat_data;
+                    chat_data.player_id = world.my_player_id;
+                    strncpy(chat_data.text, chat_input_buf, MAX_CHAT_MESSAGE_LENGTH);
+                    msg.setData(chat_data);
+                    if (queueRequest(simulation.requests, msg)) strcpy(chat_input_buf, ""); // else keep the text
+                }
+                chat_input_active = false;
+            }
+            if(ImGui::IsWindowFocused()){ chat_input_active = true; }
+            ImGui::PopItemWidth();
+            ImGui::End();
+            if(const PlayerView* me = world.find(world.my_player_id)) {
+                if(me->health <= 0 && world.game_state == GameState::IN_PROGRESS){
+                    ImGui::SetNextWindowPos(ImVec2(SCR_WIDTH * 0.5f, SCR_HEIGHT * 0.5f), ImGuiCond_Always, ImVec2(0.5,0.5));
+                    ImGui::SetNextWindowSize(ImVec2(400,100));
+                    ImGui::Begin("Eliminated", NULL, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
+                    ImGui::Text("\n           YOU ARE ELIMINATED!");
+                    ImGui::Text("           Respawning soon...");
+                    ImGui::End();
+                }
+            }
+            if(world.game_state == GameState::GAME_OVER){
+                ImGui::SetNextWindowPos(ImVec2(SCR_WIDTH * 0.5f, SCR_HEIGHT * 0.5f), ImGuiCond_Always, ImVec2(0.5,0.5));
+                ImGui::SetNextWindowSize(ImVec2(400,120));
+                ImGui::Begin("Game Over", NULL, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
+                ImGui::Text("\n              GAME OVER!");
+                ImGui::Text("           Player %u is the winner!", world.winner_id);
+                ImGui::Text("\n         Returning to lobby soon...");
+                ImGui::End();
+            }
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+        {
+            TRACE_SCOPE("swap");
+            glfwSwapBuffers(window);
+        }
+        glfwPollEvents();
+    }
+
+    // Cleanup
+    simulation.stop.store(true, std::memory_order_release);
+    if(simulation_thread.joinable()) { simulation_thread.join(); }
+    client.close();
+    if(network_thread.joinable()) { network_thread.join(); }
+    const auto ev_stats = client.event_stats();
+    LOG_INFO("[Client] Network events: {} received, {} dropped, ring high water {}/{}",
+             ev_stats.pushed, ev_stats.dropped, ev_stats.high_water, NetworkClient::kEventCapacity);
+    const auto udp_stats = client.udp_recv_stats();
+    LOG_INFO("[Client] UDP receive: {} datagrams, {} bytes in {} wakeups (max batch {}), dropped {} foreign, {} malformed, {} errors",
+             udp_stats.datagrams, udp_stats.bytes, udp_stats.wakeups, udp_stats.max_batch,
+             udp_stats.foreign, udp_stats.malformed, udp_stats.errors);
+    if (tracers.dropped() > 0)
+        LOG_WARN("[Client] {} tracer segments dropped (line batch full)", tracers.dropped());
+    glfwTerminate();
+    return 0;
+}
+
+// Simulation thread: drains network events, predicts our player, interpolates the
+// others and moves particles every kSimulationStep, then publishes a FrameSnapshot.
+// The only caller of client.send() and poll_event(); never touches GL, GLFW or audio.
+void runSimulation(NetworkClient& client, SimulationChannels& channels) {
+    trace::set_thread_name("simulation");
+    const float dt = std::chrono::duration<float>(kSimulationStep).count();
 
     // Game State
     uint32_t my_player_id = 0;
     std::map<uint32_t, Player> server_player_states;
+    SnapshotClock snapshot_clock;
     Player my_predicted_state;
     my_predicted_state.position = glm::vec3(0.0f, 0.0f, 3.0f);
     my_predicted_state.visual_position = my_predicted_state.position;
-    auto last_input_send_time = std::chrono::steady_clock::now();
-    int my_last_health = 100;
-    std::list<Projectile> projectiles;
+    InputFrameHistory input_history;
+    auto next_input_sample_time = std::chrono::steady_clock::now();
+    ParticlePool projectiles(1024);
+    ParticlePool effects(1024);
     GameState current_game_state = GameState::LOBBY;
     uint32_t winner_id = 0;
-    char chat_input_buf[MAX_CHAT_MESSAGE_LENGTH] = "";
     std::vector<std::string> chat_history;
+    uint32_t chat_generation = 0;
+    uint64_t hits = 0;
+    PlayerInputData current_input = {};
 
-    // Game Loop
-    while (!glfwWindowShouldClose(window)) {
-        float currentFrame = (float)glfwGetTime();
-        deltaTime = currentFrame - lastFrame; lastFrame = currentFrame;
-
-        PlayerInputData current_input = {};
-        processInput(window, current_input, client, shootSound, current_game_state);
+    auto next_step = std::chrono::steady_clock::now();
+    while (!channels.stop.load(std::memory_order_acquire)) {
+        TRACE_SCOPE("step");
+        // Keys and camera orientation as of the last rendered frame
+        if (channels.input.consume()) current_input = channels.input.read_slot();
+        GameMessage request;
+        while (channels.requests.try_pop(request)) client.send(request);
 
         if (current_game_state == GameState::IN_PROGRESS && my_player_id != 0 && server_player_states.count(my_player_id) && server_player_states.at(my_player_id).health > 0) {
             const float PLAYER_SPEED = 2.5f;
-            my_predicted_state.rotation = camera.getRotationQuat();
+            my_predicted_state.rotation = current_input.rotation;
             glm::vec3 forward = my_predicted_state.rotation * glm::vec3(0, 0, -1);
             glm::vec3 right = my_predicted_state.rotation * glm::vec3(1, 0, 0);
-            if (current_input.up) my_predicted_state.position += forward * PLAYER_SPEED * deltaTime;
-            if (current_input.down) my_predicted_state.position -= forward * PLAYER_SPEED * deltaTime;
-            if (current_input.left) my_predicted_state.position -= right * PLAYER_SPEED * deltaTime;
-            if (current_input.right) my_predicted_state.position += right * PLAYER_SPEED * deltaTime;
+            if (current_input.up) my_predicted_state.position += forward * PLAYER_SPEED * dt;
+            if (current_input.down) my_predicted_state.position -= forward * PLAYER_SPEED * dt;
+            if (current_input.left) my_predicted_state.position -= right * PLAYER_SPEED * dt;
+            if (current_input.right) my_predicted_state.position += right * PLAYER_SPEED * dt;
         }
         
         { 
-            std::lock_guard<std::mutex> lock(client.incoming_mutex);
-            // Process reliable TCP messages
-            while (!client.incoming_tcp_messages.empty()) {
-                GameMessage msg = client.incoming_tcp_messages.front();
-                client.incoming_tcp_messages.pop_front();
-                
+            TRACE_SCOPE("drain_messages");
+            // Lock-free: the IO thread keeps decoding into the ring while we drain it
+            NetEvent msg;
+            while (client.poll_event(msg)) {
                 if (msg.type == MessageType::PlayerJoin && my_player_id == 0) {
                     const auto& join_data = msg.getData<PlayerStateData>();
                     my_player_id = join_data.id;
@@ -164,7 +567,16 @@ int main() {
                 switch (msg.type) {
                     case MessageType::PlayerJoin: {
                         const auto& join_data = msg.getData<PlayerStateData>();
-                        server_player_states[join_data.id] = { join_data.position, join_data.rotation, join_data.position, {join_data.box_min, join_data.box_max}, join_data.health, join_data.kills, join_data.deaths, join_data.is_ready};
+                        Player joined;
+                        joined.position = join_data.position;
+                        joined.rotation = join_data.rotation;
+                        joined.visual_position = join_data.position;
+                        joined.bounding_box = { join_data.box_min, join_data.box_max };
+                        joined.health = join_data.health;
+                        joined.kills = join_data.kills;
+                        joined.deaths = join_data.deaths;
+                        joined.is_ready = join_data.is_ready;
+                        server_player_states[join_data.id] = std::move(joined);
                         break;
                     }
                     case MessageType::PlayerLeave: {
@@ -173,27 +585,31 @@ int main() {
                         break;
                     }
                     case MessageType::PlayerState: {
-                        const auto& all_states_data = msg.getData<AllPlayersStateData>();
-                        for (int i = 0; i < all_states_data.count; ++i) {
-                            const auto& state_data = all_states_data.players[i];
-                            if (server_player_states.count(state_data.id)) {
-                                if (state_data.id != my_player_id) { 
-                                    server_player_states[state_data.id].position = state_data.position;
-                                    server_player_states[state_data.id].rotation = state_data.rotation;
-                                }
-                                server_player_states[state_data.id].bounding_box.min = state_data.box_min;
-                                server_player_states[state_data.id].bounding_box.max = state_data.box_max;
-                                server_player_states[state_data.id].health = state_data.health;
-                                server_player_states[state_data.id].kills = state_data.kills;
-                                server_player_states[state_data.id].deaths = state_data.deaths;
-                                server_player_states[state_data.id].is_ready = state_data.is_ready;
+                        // One event per player in the snapshot
+                        const auto& state_data = msg.getData<PlayerStateData>();
+                        snapshot_clock.on_snapshot(msg.tick, msg.received);
+                        if (server_player_states.count(state_data.id)) {
+                            if (state_data.id != my_player_id) { 
+                                server_player_states[state_data.id].position = state_data.position;
+                                server_player_states[state_data.id].rotation = state_data.rotation;
+                                server_player_states[state_data.id].snapshots.push(msg.tick, state_data.position, state_data.rotation);
+                            } else {
+                                // Server's authoritative position for our own player (reconciliation)
+                                server_player_states[state_data.id].position = state_data.position;
                             }
+                            server_player_states[state_data.id].bounding_box.min = state_data.box_min;
+                            server_player_states[state_data.id].bounding_box.max = state_data.box_max;
+                            server_player_states[state_data.id].health = state_data.health;
+                            server_player_states[state_data.id].kills = state_data.kills;
+                            server_player_states[state_data.id].deaths = state_data.deaths;
+                            server_player_states[state_data.id].is_ready = state_data.is_ready;
                         }
                         break;
                     }
                     case MessageType::ProjectileSpawn: {
                         const auto& spawn_data = msg.getData<ProjectileData>();
-                        projectiles.push_back({spawn_data.start_position, spawn_data.direction});
+                        projectiles.spawn(spawn_data.start_position, spawn_data.direction,
+                                          kProjectileSpeed, kProjectileLifetime, 0.5f, kTracerColor);
                         break;
                     }
                     case MessageType::GameStateUpdate: {
@@ -202,15 +618,23 @@ int main() {
                         winner_id = state_data.winner_id;
                         if(current_game_state == GameState::IN_PROGRESS || current_game_state == GameState::LOBBY){
                             projectiles.clear();
+                            effects.clear();
                         }
                         break;
                     }
                     case MessageType::PlayerHit: {
                         const auto& hit_data = msg.getData<PlayerHitData>();
                         if (server_player_states.count(hit_data.victim_id)) {
-                            server_player_states.at(hit_data.victim_id).health = hit_data.new_health;
+                            Player& victim = server_player_states.at(hit_data.victim_id);
+                            victim.health = hit_data.new_health;
+                            // Burst of sparks out of the hitbox centre along the cube diagonals
+                            const glm::vec3 center = (victim.bounding_box.min + victim.bounding_box.max) * 0.5f;
+                            for (int i = 0; i < 8; ++i) {
+                                const glm::vec3 dir = glm::normalize(glm::vec3(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f));
+                                effects.spawn(center, dir, 6.0f, 0.25f, 0.15f, kHitSparkColor);
+                            }
                         }
-                        hitSound.play();
+                        hits++; // played by the render thread
                         break;
                     }
                     case MessageType::PlayerRespawn: {
@@ -218,6 +642,7 @@ int main() {
                         if (server_player_states.count(respawn_data.player_id)) {
                             server_player_states.at(respawn_data.player_id).health = 100;
                             server_player_states.at(respawn_data.player_id).position = respawn_data.position;
+                            server_player_states.at(respawn_data.player_id).snapshots.clear(); // don't interpolate across the teleport
                         }
                         break;
                     }
@@ -226,243 +651,89 @@ int main() {
                         std::string chat_msg = "Player " + std::to_string(chat_data.player_id) + ": " + chat_data.text;
                         chat_history.push_back(chat_msg);
                         if(chat_history.size() > 10) chat_history.erase(chat_history.begin());
+                        chat_generation++;
                         break;
                     }
                     default: break;
                 }
             }
-            
-            // Process fast UDP messages
-            while (!client.incoming_udp_messages.empty()) {
-                UDPMessage msg = client.incoming_udp_messages.front();
-                client.incoming_udp_messages.pop_front();
-                
-                if (server_player_states.count(msg.player_id)) {
-                    if (msg.player_id != my_player_id) {
-                        server_player_states.at(msg.player_id).position = msg.position;
-                        server_player_states.at(msg.player_id).rotation = msg.rotation;
-                    } else {
-                        // This is the server's authoritative position for our own player.
-                        // We can use this for server reconciliation to correct our prediction.
-                        server_player_states.at(my_player_id).position = msg.position;
-                    }
-                }
-            }
-        }
-        
-        if (my_player_id != 0 && server_player_states.count(my_player_id)) { 
-            my_predicted_state.position = server_player_states.at(my_player_id).position; 
-        }
-        my_predicted_state.visual_position = glm::mix(my_predicted_state.visual_position, my_predicted_state.position, 15.0f * deltaTime);
-        for(auto& pair : server_player_states){
-            if(pair.first != my_player_id){
-                pair.second.visual_position = glm::mix(pair.second.visual_position, pair.second.position, 15.0f * deltaTime);
-            }
-        }
-        for (auto it = projectiles.begin(); it != projectiles.end(); ) {
-            it->position += it->direction * it->speed * deltaTime;
-            it->lifetime -= deltaTime;
-            if (it->lifetime <= 0) { it = projectiles.erase(it); } else { ++it; }
-        }
-        
-        auto now = std::chrono::steady_clock::now();
-        if (std::chrono::duration_cast<std::chrono::milliseconds>(now - last_input_send_time).count() > 50) {
-            GameMessage input_msg;
-            input_msg.type = MessageType::PlayerInput;
-            current_input.rotation = camera.getRotationQuat();
-            input_msg.setData(current_input);
-            client.send_tcp(input_msg);
-            last_input_send_time = now;
         }
         
-        glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        
-        ImGui_ImplOpenGL3_NewFrame(); ImGui_ImplGlfw_NewFrame(); ImGui::NewFrame();
-        
-        if (current_game_state == GameState::LOBBY) {
-            show_cursor = true;
-            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
-            ImGui::SetNextWindowPos(ImVec2(SCR_WIDTH * 0.5f, SCR_HEIGHT * 0.5f), ImGuiCond_Always, ImVec2(0.5,0.5));
-            ImGui::SetNextWindowSize(ImVec2(400,300), ImGuiCond_Always);
-            ImGui::Begin("Lobby", NULL, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
-            ImGui::Text("Waiting for players (2 needed to start)...");
-            ImGui::Separator();
-            if (ImGui::BeginTable("lobby_players", 2, ImGuiTableFlags_Borders)) {
-                ImGui::TableSetupColumn("Player ID"); ImGui::TableSetupColumn("Status");
-                ImGui::TableHeadersRow();
-                for(const auto& [id, player] : server_player_states){
-                    ImGui::TableNextRow();
-                    ImGui::TableSetColumnIndex(0); ImGui::Text("%u", id);
-                    ImGui::TableSetColumnIndex(1);
-                    if(player.is_ready) { ImGui::TextColored(ImVec4(0,1,0,1), "Ready"); } 
-                    else { ImGui::Text("Not Ready"); }
-                }
-                ImGui::EndTable();
-            }
-            ImGui::Separator();
-            if (server_player_states.count(my_player_id) && !server_player_states.at(my_player_id).is_ready) {
-            if (ImGui::Button("Ready Up", ImVec2(-1, 40))) {
-                GameMessage ready_msg;
-                ready_msg.type = MessageType::ClientReady;
-                ready_msg.setData(ClientReadyData{});
-                client.send_tcp(ready_msg);
-                }
-                ImGui::Text("Waiting for other players to ready up...");
-            }
-
-            ImGui::End();
-        } else {
-            if (!chat_input_active) {
-                show_cursor = false;
-                glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        {
+            TRACE_SCOPE("simulation");
+            if (my_player_id != 0 && server_player_states.count(my_player_id)) { 
+                my_predicted_state.position = server_player_states.at(my_player_id).position; 
             }
-            if(my_player_id != 0 && server_player_states.count(my_player_id)){
-                glm::vec3 player_visual_pos = my_predicted_state.visual_position;
-                float distance_from_player = 5.0f;
-                camera.Position = player_visual_pos - (camera.Front * distance_from_player) + glm::vec3(0.0, 1.5, 0.0);
-            }
-            glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-            glm::mat4 view = camera.GetViewMatrix();
-            ourShader.use();
-            ourShader.setMat4("projection", projection);
-            ourShader.setMat4("view", view);
-            glm::vec3 lightPos(0.0f, 10.0f, 10.0f);
-            ourShader.setVec3("viewPos", camera.Position);
-            ourShader.setVec3("light.position", lightPos);
-            ourShader.setVec3("light.ambient", 0.2f, 0.2f, 0.2f);
-            ourShader.setVec3("light.diffuse", 0.8f, 0.8f, 0.8f);
-            ourShader.setVec3("light.specular", 1.0f, 1.0f, 1.0f);
-            ourShader.setFloat("material.shininess", 32.0f);
-            glBindVertexArray(worldVAO);
-            for(const auto& object : static_objects){
-                glm::mat4 model = glm::mat4(1.0f);
-                model = glm::translate(model, object.position);
-                model = glm::scale(model, object.scale);
-                ourShader.setMat4("model", model);
-                ourShader.setVec3("objectColor", object.color);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-            }
-            for (const auto& [id, state] : server_player_states) {
-                if (state.health <= 0) continue;
-                glm::mat4 model = glm::mat4(1.0f);
-                if (id == my_player_id) {
-                    model = glm::translate(model, my_predicted_state.visual_position);
-                    model = model * glm::mat4_cast(camera.getRotationQuat());
-                } else {
-                    model = glm::translate(model, state.visual_position);
-                    model = model * glm::mat4_cast(state.rotation);
+            my_predicted_state.visual_position = glm::mix(my_predicted_state.visual_position, my_predicted_state.position, 15.0f * dt);
+            // Remote players: interpolated between buffered snapshots, a jitter-adaptive delay behind the server
+            const double render_tick = snapshot_clock.render_tick(std::chrono::steady_clock::now());
+            for(auto& pair : server_player_states){
+                if(pair.first == my_player_id) continue;
+                Player& p = pair.second;
+                if (!snapshot_clock.ready() || !p.snapshots.sample(render_tick, p.visual_position, p.visual_rotation)) {
+                    p.visual_position = p.position;
+                    p.visual_rotation = p.rotation;
                 }
-                ourShader.setMat4("model", model);
-                ourModel.Draw(ourShader);
-            }
-            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-            debugShader.use();
-            debugShader.setMat4("projection", projection);
-            debugShader.setMat4("view", view);
-            debugShader.setVec3("color", 0.0f, 1.0f, 0.0f);
-            for (const auto& [id, state] : server_player_states) {
-                if (state.health <= 0) continue;
-                glm::vec3 size = state.bounding_box.max - state.bounding_box.min;
-                glm::vec3 center = state.bounding_box.min + size * 0.5f;
-                glm::mat4 model = glm::mat4(1.0f);
-                model = glm::translate(model, center);
-                model = glm::scale(model, size);
-                debugShader.setMat4("model", model);
-                glBindVertexArray(worldVAO);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-            }
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-            debugShader.use();
-            debugShader.setMat4("projection", projection);
-            debugShader.setMat4("view", view);
-            debugShader.setVec3("color", 1.0f, 1.0f, 0.0f);
-            glLineWidth(3.0f);
-            for (const auto& p : projectiles) {
-                glm::vec3 end_pos = p.position + p.direction * 0.5f;
-                float line_verts[] = { p.position.x, p.position.y, p.position.z, end_pos.x, end_pos.y, end_pos.z };
-                glBindVertexArray(projectileVAO);
-                glBindBuffer(GL_ARRAY_BUFFER, projectileVBO);
-                glBufferData(GL_ARRAY_BUFFER, sizeof(line_verts), line_verts, GL_DYNAMIC_DRAW);
-                glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-                glEnableVertexAttribArray(0);
-                glDrawArrays(GL_LINES, 0, 2);
             }
-            glLineWidth(1.0f);
-            glBindVertexArray(0);
-        }
-        ImGui::SetNextWindowPos(ImVec2(SCR_WIDTH - 260, 10), ImGuiCond_Always);
-        ImGui::SetNextWindowSize(ImVec2(250, 150), ImGuiCond_Always);
-        ImGui::Begin("Scoreboard", NULL, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
-        if (ImGui::BeginTable("scores", 3, ImGuiTableFlags_Borders)) {
-            ImGui::TableSetupColumn("Player ID"); ImGui::TableSetupColumn("Kills"); ImGui::TableSetupColumn("Deaths");
-            ImGui::TableHeadersRow();
-            for(const auto& [id, player] : server_player_states) {
-                ImGui::TableNextRow();
-                ImGui::TableSetColumnIndex(0); ImGui::Text("%u", id);
-                ImGui::TableSetColumnIndex(1); ImGui::Text("%d", player.kills);
-                ImGui::TableSetColumnIndex(2); ImGui::Text("%d", player.deaths);
-            }
-            ImGui::EndTable();
-        }
-        ImGui::End();
-        ImGui::SetNextWindowPos(ImVec2(10, SCR_HEIGHT - 160), ImGuiCond_Always);
-        ImGui::SetNextWindowSize(ImVec2(400, 150), ImGuiCond_Always);
-        ImGui::Begin("Chat", NULL, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
-        ImGui::BeginChild("ChatHistory", ImVec2(0, -ImGui::GetFrameHeightWithSpacing()));
-        for(const auto& msg : chat_history){ ImGui::TextUnformatted(msg.c_str()); }
-        ImGui::EndChild();
-        ImGui::PushItemWidth(-1);
-        if(chat_input_active) ImGui::SetKeyboardFocusHere();
-        if(ImGui::InputText("##chat", chat_input_buf, MAX_CHAT_MESSAGE_LENGTH, ImGuiInputTextFlags_EnterReturnsTrue)){
-            if(strlen(chat_input_buf) > 0){
-                GameMessage msg;
-                msg.type = MessageType::ChatMessage;
-                ChatMessageData chat_data;
-                chat_data.player_id = my_player_id;
-                strncpy(chat_data.text, chat_input_buf, MAX_CHAT_MESSAGE_LENGTH);
-                msg.setData(chat_data);
-                client.send_tcp(msg);
-                strcpy(chat_input_buf, "");
+            projectiles.update(dt);
+            effects.update(dt);
+        
+            // Sample input once per server tick; each message repeats the last MAX_INPUT_FRAMES frames.
+            // Only during a match: the server discards input in the lobby and after game over.
+            auto now = std::chrono::steady_clock::now();
+            const bool playing = current_game_state == GameState::IN_PROGRESS && my_player_id != 0;
+            if (!playing || now - next_input_sample_time > 10 * kInputFrameInterval) next_input_sample_time = now; // after a stall
+            bool sampled = false;
+            while (playing && next_input_sample_time <= now) {
+                input_history.push(current_input);
+                next_input_sample_time += kInputFrameInterval;
+                sampled = true;
             }
-            chat_input_active = false;
+            if (sampled) client.send(input_history.make_message());
         }
-        if(ImGui::IsWindowFocused()){ chat_input_active = true; }
-        ImGui::PopItemWidth();
-        ImGui::End();
-        if(server_player_states.count(my_player_id)) {
-            if(server_player_states.at(my_player_id).health <= 0 && current_game_state == GameState::IN_PROGRESS){
-                ImGui::SetNextWindowPos(ImVec2(SCR_WIDTH * 0.5f, SCR_HEIGHT * 0.5f), ImGuiCond_Always, ImVec2(0.5,0.5));
-                ImGui::SetNextWindowSize(ImVec2(400,100));
-                ImGui::Begin("Eliminated", NULL, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
-                ImGui::Text("\n           YOU ARE ELIMINATED!");
-                ImGui::Text("           Respawning soon...");
-                ImGui::End();
+
+        {
+            TRACE_SCOPE("publish");
+            FrameSnapshot& out = channels.frames.write_slot();
+            out.my_player_id = my_player_id;
+            out.my_visual_position = my_predicted_state.visual_position;
+            out.game_state = current_game_state;
+            out.winner_id = winner_id;
+            out.players.clear();
+            for (const auto& [id, p] : server_player_states)
+                out.players.push_back({ id, p.visual_position, p.visual_rotation, p.bounding_box, p.health, p.kills, p.deaths, p.is_ready });
+            out.tracers.clear();
+            for (std::size_t i = 0; i < projectiles.size(); ++i)
+                out.tracers.push_back({ projectiles.position(i), projectiles.tail(i), projectiles.color(i) });
+            for (std::size_t i = 0; i < effects.size(); ++i)
+                out.tracers.push_back({ effects.position(i), effects.tail(i), effects.color(i) });
+            if (out.chat_generation != chat_generation) { // each slot holds its own copy
+                out.chat_history = chat_history;
+                out.chat_generation = chat_generation;
             }
+            out.hits = hits;
+            out.interp_delay_ms = snapshot_clock.delay_ms();
+            channels.frames.publish();
         }
-        if(current_game_state == GameState::GAME_OVER){
-            ImGui::SetNextWindowPos(ImVec2(SCR_WIDTH * 0.5f, SCR_HEIGHT * 0.5f), ImGuiCond_Always, ImVec2(0.5,0.5));
-            ImGui::SetNextWindowSize(ImVec2(400,120));
-            ImGui::Begin("Game Over", NULL, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
-            ImGui::Text("\n              GAME OVER!");
-            ImGui::Text("           Player %u is the winner!", winner_id);
-            ImGui::Text("\n         Returning to lobby soon...");
-            ImGui::End();
-        }
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+
+        next_step += kSimulationStep;
+        const auto now = std::chrono::steady_clock::now();
+        if (now - next_step > 10 * kSimulationStep) next_step = now; // after a stall: no burst of catch-up steps
+        std::this_thread::sleep_until(next_step);
     }
 
-    // Cleanup
-    client.close();
-    if(network_thread.joinable()) { network_thread.join(); }
-    glfwTerminate();
-    return 0;
+    if (projectiles.dropped() + effects.dropped() > 0)
+        LOG_WARN("[Client] Particle pools full: {} projectiles, {} effects dropped", projectiles.dropped(), effects.dropped());
 }
 
-void processInput(GLFWwindow *window, PlayerInputData& input, NetworkClient& client, sf::Sound& shootSound, const GameState& gameState) {
+// Hands msg to the simulation thread for sending; false if the ring is full (logged)
+bool queueRequest(OutgoingRequests& requests, const GameMessage& msg) {
+    if (requests.try_push(msg)) return true;
+    LOG_WARN("[Client] Request ring full, dropped {}", message_type_name(msg.type));
+    return false;
+}
+
+void processInput(GLFWwindow *window, PlayerInputData& input, OutgoingRequests& requests, sf::Sound& shootSound, GameState gameState) {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
     static bool chat_key_pressed = false;
@@ -487,8 +758,7 @@ void processInput(GLFWwindow *window, PlayerInputData& input, NetworkClient& cli
             GameMessage msg;
             msg.type = MessageType::PlayerShoot;
             msg.setData(PlayerShootData{});
-            client.send_tcp(msg);
-            shootSound.play();
+            if (queueRequest(requests, msg)) shootSound.play();
             shoot_key_pressed = true;
         }
     } else { shoot_key_pressed = false; }
@@ -498,6 +768,26 @@ void processInput(GLFWwindow *window, PlayerInputData& input, NetworkClient& cli
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) { input.right = true; }
 }
 
+// F9 starts a trace capture; pressing it again writes client_trace_<n>.json for Perfetto / chrome://tracing
+void toggleTraceCapture(GLFWwindow* window) {
+    static bool trace_key_pressed = false;
+    static int trace_index = 0;
+    if (glfwGetKey(window, GLFW_KEY_F9) != GLFW_PRESS) { trace_key_pressed = false; return; }
+    if (trace_key_pressed) return;
+    trace_key_pressed = true;
+    if (!trace::kCompiledIn) { LOG_WARN("[Client] Built without GAME_ENABLE_TRACING"); return; }
+    if (!trace::capturing()) {
+        trace::start();
+        LOG_INFO("[Client] Trace capture started (F9 to stop)");
+        return;
+    }
+    trace::stop();
+    std::string path = "client_trace_" + std::to_string(trace_index++) + ".json";
+    std::ofstream out(path);
+    out << trace::to_chrome_json("client");
+    LOG_INFO("[Client] Trace written to {}", path);
+}
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) { glViewport(0, 0, width, height); }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
@@ -4,6 +4,7 @@ out vec4 FragColor;
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
+in vec4 Color;
 
 struct Material {
     sampler2D texture_diffuse1;
@@ -11,35 +12,35 @@ struct Material {
     float shininess;
 }; 
 
-struct Light {
-    vec3 position;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
+layout (std140) uniform Frame {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    vec4 lightPosition;
+    vec4 lightAmbient;
+    vec4 lightDiffuse;
+    vec4 lightSpecular;
 };
 
-uniform vec3 viewPos;
 uniform Material material;
-uniform Light light;
 
 void main()
 {    
     // ambient
-    vec3 ambient = light.ambient * texture(material.texture_diffuse1, TexCoords).rgb;
+    vec3 ambient = lightAmbient.rgb * texture(material.texture_diffuse1, TexCoords).rgb;
   	
     // diffuse 
     vec3 norm = normalize(Normal);
-    vec3 lightDir = normalize(light.position - FragPos);
+    vec3 lightDir = normalize(lightPosition.xyz - FragPos);
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = light.diffuse * diff * texture(material.texture_diffuse1, TexCoords).rgb;  
+    vec3 diffuse = lightDiffuse.rgb * diff * texture(material.texture_diffuse1, TexCoords).rgb;  
     
     // specular
-    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 viewDir = normalize(viewPos.xyz - FragPos);
     vec3 reflectDir = reflect(-lightDir, norm);  
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    vec3 specular = light.specular * spec * texture(material.texture_specular1, TexCoords).rgb;  
+    vec3 specular = lightSpecular.rgb * spec * texture(material.texture_specular1, TexCoords).rgb;  
         
     vec3 result = ambient + diffuse + specular;
-    FragColor = vec4(result, 1.0);
+    FragColor = vec4(result * Color.rgb, Color.a);
 }
\ No newline at end of file
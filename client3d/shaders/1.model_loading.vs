@@ -2,20 +2,33 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in mat4 aModel;   // per instance (locations 3-6)
+layout (location = 7) in vec4 aColor;   // per instance
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
+out vec4 Color;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform vec3 positionScale;    // quantized meshes: aPos is in [0,1] of the mesh bounds
+uniform vec3 positionOffset;
+
+layout (std140) uniform Frame {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    vec4 lightPosition;
+    vec4 lightAmbient;
+    vec4 lightDiffuse;
+    vec4 lightSpecular;
+};
 
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;  
+    FragPos = vec3(aModel * vec4(aPos * positionScale + positionOffset, 1.0));
+    Normal = mat3(transpose(inverse(aModel))) * aNormal;  
     TexCoords = aTexCoords;
+    Color = aColor;
     
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
\ No newline at end of file
@@ -1,9 +1,9 @@
 #version 330 core
 out vec4 FragColor;
 
-uniform vec3 color;
+in vec4 Color;
 
 void main()
 {
-    FragColor = vec4(color, 1.0);
+    FragColor = Color;
 }
\ No newline at end of file
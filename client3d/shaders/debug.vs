@@ -1,11 +1,22 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
+layout (location = 3) in mat4 aModel;   // per instance (locations 3-6)
+layout (location = 7) in vec4 aColor;   // per instance
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+out vec4 Color;
+
+layout (std140) uniform Frame {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    vec4 lightPosition;
+    vec4 lightAmbient;
+    vec4 lightDiffuse;
+    vec4 lightSpecular;
+};
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    Color = aColor;
+    gl_Position = projection * view * aModel * vec4(aPos, 1.0);
 }
\ No newline at end of file
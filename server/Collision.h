@@ -0,0 +1,27 @@
+// Collision.h
+// Server-side collision and hitscan primitives.
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+struct AABB { glm::vec3 min; glm::vec3 max; };
+
+inline bool aabb_overlap(const AABB& a, const AABB& b) {
+    return (a.min.x <= b.max.x && a.max.x >= b.min.x) &&
+           (a.min.y <= b.max.y && a.max.y >= b.min.y) &&
+           (a.min.z <= b.max.z && a.max.z >= b.min.z);
+}
+
+// Very simple hitscan: dot and distance check
+constexpr float kHitscanRange = 50.0f;
+constexpr float kHitscanCone = 0.95f;
+
+inline bool hitscan_hits(const glm::vec3& origin, const glm::vec3& forward, const glm::vec3& target) {
+    glm::vec3 diff = target - origin;
+    float dist2 = glm::dot(diff, diff);
+    if (dist2 > kHitscanRange * kHitscanRange) return false;
+
+    glm::vec3 dir_to_target = glm::normalize(diff);
+    return glm::dot(forward, dir_to_target) > kHitscanCone;
+}
@@ -0,0 +1,775 @@
+// Game.cpp
+// Session and Game implementation (see Game.h).
+
+#include "Game.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "MatchRecorder.h"
+#include "Serialization.h"
+#include "../shared/input_frames.h"
+#include "../shared/log.h"
+#include "../shared/trace.h"
+
+Game::Game(boost::asio::io_context& io, unsigned short tcp_port, unsigned short udp_port)
+    : io_(io),
+      acceptor_(io, tcp::endpoint(tcp::v4(), tcp_port)),
+      udp_socket_(io, udp::endpoint(udp::v4(), udp_port)),
+      tick_(io, kTickInterval),
+      seed_(std::random_device{}()),
+      rng_(seed_),
+      spawn_rng_(-10, 10),
+      token_rng_(std::random_device{}()) {
+    // Simple world colliders like your client scene
+    colliders_.push_back({{ -20.f, -1.5f, -20.f }, { 20.f, -0.5f, 20.f }}); // "ground slab"
+    colliders_.push_back({{ -5.f, -0.5f, -5.f },  { -3.f,  1.5f, -3.f }});   // red box
+    colliders_.push_back({{  3.f, -0.5f,  4.f },  {  5.f,  1.5f,  6.f }});   // blue box
+}
+
+void Game::start() {
+    do_accept();
+    do_receive_udp();
+    next_tick_ = std::chrono::steady_clock::now();
+    tick_loop();
+}
+
+// ====================== Session implementation ======================
+
+void Session::start() { read_header(); }
+
+void Session::deliver(const GameMessage& msg) {
+    TRACE_SCOPE("Session::deliver");
+    auto body = serialize_game_message(msg);
+    game_.metrics().message_out(msg.type, header_len + body.size());
+    if (stats_) stats_->traffic.add_out(header_len + body.size());
+
+    bool writing = !write_q_.empty();
+    write_q_.push_back(std::move(body));
+    if (stats_) stats_->set_write_queue_depth(write_q_.size());
+    if (!writing) write_next();
+}
+
+void Session::read_header() {
+    auto self = shared_from_this();
+    boost::asio::async_read(
+        socket_,
+        boost::asio::buffer(header_buf_.data(), header_len),
+        [this, self](boost::system::error_code ec, std::size_t /*n*/) {
+            if (ec) { game_.leave(self); return; }
+            uint32_t body_len = 0;
+            std::memcpy(&body_len, header_buf_.data(), sizeof(uint32_t));
+            if (body_len == 0 || body_len > 4096) { game_.leave(self); return; }
+            body_buf_.resize(body_len);
+            read_body(body_len);
+        }
+    );
+}
+
+void Session::read_body(std::size_t body_len) {
+    auto self = shared_from_this();
+    boost::asio::async_read(
+        socket_,
+        boost::asio::buffer(body_buf_.data(), body_len),
+        [this, self](boost::system::error_code ec, std::size_t /*n*/) {
+            if (ec) { game_.leave(self); return; }
+            try {
+                GameMessage m = deserialize_game_message(body_buf_);
+                game_.metrics().message_in(m.type, header_len + body_buf_.size());
+                if (stats_) stats_->traffic.add_in(header_len + body_buf_.size());
+                game_.handle_msg(id_, m);
+            } catch (...) {
+                // bad packet, drop client
+                game_.leave(self);
+                return;
+            }
+            read_header();
+        }
+    );
+}
+
+void Session::write_next() {
+    if (write_q_.empty()) return;
+
+    // Build [header][body] buffers
+    const auto& body = write_q_.front();
+    uint32_t len = static_cast<uint32_t>(body.size());
+    std::array<char, sizeof(uint32_t)> hdr{};
+    std::memcpy(hdr.data(), &len, sizeof(uint32_t));
+    std::vector<boost::asio::const_buffer> bufs;
+    bufs.emplace_back(boost::asio::buffer(hdr));
+    bufs.emplace_back(boost::asio::buffer(body));
+
+    auto self = shared_from_this();
+    boost::asio::async_write(
+        socket_,
+        bufs,
+        [this, self](boost::system::error_code ec, std::size_t /*n*/) {
+            if (ec) { game_.leave(self); return; }
+            write_q_.pop_front();
+            if (stats_) stats_->set_write_queue_depth(write_q_.size());
+            if (!write_q_.empty()) write_next();
+        }
+    );
+}
+
+// ====================== Game implementation ======================
+
+void Game::do_accept() {
+    acceptor_.async_accept([this](boost::system::error_code ec, tcp::socket sock) {
+        if (!ec) {
+            auto s = std::make_shared<Session>(std::move(sock), *this);
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                // Reserve ID; we’ll finalize join() to broadcast
+                s->set_id(next_id_++);
+                sessions_[s->id()] = s;
+            }
+            s->start();
+
+            // Complete join immediately (send PlayerJoin etc.)
+            join(s);
+        }
+        do_accept();
+    });
+}
+
+void Game::join(const std::shared_ptr<Session>& s) {
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    const PlayerRuntime& p = spawn_player(s->id());
+    if (recorder_) recorder_->player_joined(tick_count_, p.id);
+    s->set_stats(metrics_.register_session(p.id));
+    metrics_.set_connected_players(sessions_.size());
+
+    LOG_INFO("[Server] Player {} joined.", p.id);
+
+    // 1) Tell the joining client about THEMSELVES first (so client sets my_player_id correctly)
+    {
+        GameMessage msg{};
+        msg.type = MessageType::PlayerJoin;
+        PlayerStateData d{ p.id, p.position, p.rotation, p.box.min, p.box.max, p.health, p.kills, p.deaths, p.ready };
+        msg.setData(d);
+        send_to(p.id, msg);
+    }
+
+    // 2) Tell the joining client about all other existing players
+    for (const auto& [oid, op] : players_) {
+        if (oid == p.id) continue;
+        GameMessage msg{};
+        msg.type = MessageType::PlayerJoin;
+        PlayerStateData d{ op.id, op.position, op.rotation, op.box.min, op.box.max, op.health, op.kills, op.deaths, op.ready };
+        msg.setData(d);
+        send_to(p.id, msg);
+    }
+
+    // 3) Tell everyone else about the new player
+    {
+        GameMessage msg{};
+        msg.type = MessageType::PlayerJoin;
+        PlayerStateData d{ p.id, p.position, p.rotation, p.box.min, p.box.max, p.health, p.kills, p.deaths, p.ready };
+        msg.setData(d);
+        for (const auto& [sid, sess] : sessions_) {
+            if (sid == p.id) continue;
+            sess->deliver(msg);
+        }
+    }
+
+    // 4) Send current game state to the joining client
+    {
+        GameMessage gs{};
+        gs.type = MessageType::GameStateUpdate;
+        GameStateData gsd{ state_, 0 };
+        gs.setData(gsd);
+        send_to(p.id, gs);
+    }
+}
+
+uint32_t Game::add_local_player(uint32_t id) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (id == 0) id = next_id_++;
+    else next_id_ = std::max(next_id_, id + 1);
+    const PlayerRuntime& p = spawn_player(id);
+    if (recorder_) recorder_->player_joined(tick_count_, p.id);
+
+    GameMessage msg{};
+    msg.type = MessageType::PlayerJoin;
+    PlayerStateData d{ p.id, p.position, p.rotation, p.box.min, p.box.max, p.health, p.kills, p.deaths, p.ready };
+    msg.setData(d);
+    broadcast(msg);
+    return p.id;
+}
+
+void Game::handle_handshake(uint32_t sender_id, const GameMessage& msg) {
+    PlayerRuntime& p = players_.at(sender_id);
+    HandshakeResultData r{};
+    r.player_id = sender_id;
+
+    auto reply = [&](bool ok, const char* text) {
+        r.success = ok;
+        std::strncpy(r.message, text, sizeof(r.message) - 1);
+        GameMessage out{};
+        out.type = MessageType::HandshakeResult;
+        out.setData(r);
+        send_to(sender_id, out);
+    };
+
+    if (msg.getData<HandshakeData>().version != GAME_VERSION) {
+        reply(false, "version mismatch");
+        return;
+    }
+
+    // Repeated handshakes keep their slot but get a fresh token
+    int slot = p.udp_slot;
+    for (int i = 0; slot < 0 && i < static_cast<int>(udp_slots_.size()); ++i)
+        if (!udp_slots_[i].active) slot = i;
+    if (slot < 0) {
+        reply(false, "no UDP slot available");
+        return;
+    }
+
+    UdpSlot& s = udp_slots_[slot];
+    s = UdpSlot{};
+    s.active = true;
+    s.player_id = sender_id;
+    s.conn = std::make_unique<ReliableEndpoint>();
+    s.send_buffers = std::make_shared<UdpSlot::SendBuffers>();
+    auto session = sessions_.find(sender_id);
+    if (session != sessions_.end()) s.stats = session->second->stats_ptr();
+    do { s.token = token_rng_(); } while (s.token == 0);
+    p.udp_slot = slot;
+
+    r.udp_slot = static_cast<uint16_t>(slot);
+    r.udp_token = s.token;
+    reply(true, "ok");
+}
+
+void Game::handle_ping(uint32_t sender_id, const GameMessage& msg) {
+    PlayerRuntime& p = players_.at(sender_id);
+    UdpSlot* slot = p.udp_slot >= 0 && udp_slots_[p.udp_slot].bound ? &udp_slots_[p.udp_slot] : nullptr;
+
+    if (msg.type == MessageType::Ping) {
+        // Client clock sync: echo, plus where we are in the tick. Sent now rather than
+        // with the next tick's packet, which would add up to a tick to the RTT.
+        const auto ping = msg.getData<PingData>();
+        const auto now = std::chrono::steady_clock::now();
+        const auto age = std::chrono::duration_cast<std::chrono::microseconds>(now - last_tick_start_).count();
+        GameMessage out{};
+        out.type = MessageType::Pong;
+        out.setData(PongData{ ping.id, ping.sent_us, static_cast<uint32_t>(tick_count_),
+                              static_cast<uint32_t>(std::clamp<int64_t>(age, 0, SERVER_TICK_US)) });
+        send_to(sender_id, out);
+        if (slot) flush_udp(*slot, now);
+        return;
+    }
+
+    // Pong to one of our Pings (tick())
+    const auto pong = msg.getData<PongData>();
+    const uint64_t now_us = steady_now_us();
+    if (pong.ping_sent_us == 0 || pong.ping_sent_us > now_us) return;
+    const uint64_t rtt_us = now_us - pong.ping_sent_us;
+    p.rtt.add_sample(rtt_us / 1000.0);
+    metrics_.rtt().record(rtt_us * 1000);
+
+    auto it = sessions_.find(sender_id);
+    if (it != sessions_.end() && it->second->stats()) {
+        SessionStats& st = *it->second->stats();
+        st.rtt_us.store(static_cast<uint64_t>(p.rtt.srtt_ms() * 1000.0), std::memory_order_relaxed);
+        st.rtt_jitter_us.store(static_cast<uint64_t>(p.rtt.jitter_ms() * 1000.0), std::memory_order_relaxed);
+    }
+}
+
+PlayerRuntime& Game::spawn_player(uint32_t id) {
+    // Create player runtime
+    PlayerRuntime p{};
+    p.id = id;
+    p.health = 100;
+    p.kills = 0;
+    p.deaths = 0;
+    p.ready = false;
+    p.position = glm::vec3(static_cast<float>(spawn_rng_(rng_)), 0.0f, static_cast<float>(spawn_rng_(rng_)));
+    p.rotation = glm::quat(1, 0, 0, 0);
+    p.update_aabb();
+    return players_[p.id] = p;
+}
+
+void Game::leave(const std::shared_ptr<Session>& s) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    const auto pid = s->id();
+    if (!sessions_.erase(pid)) return;
+
+    metrics_.unregister_session(pid);
+    metrics_.set_connected_players(sessions_.size());
+    remove_player(pid);
+
+    LOG_INFO("[Server] Player {} left.", pid);
+}
+
+void Game::remove_local_player(uint32_t id) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (players_.count(id)) remove_player(id);
+}
+
+bool Game::place_player(uint32_t id, const glm::vec3& position) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = players_.find(id);
+    if (it == players_.end()) return false;
+    it->second.position = position;
+    it->second.update_aabb();
+    return true;
+}
+
+glm::vec3 Game::player_position(uint32_t id) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = players_.find(id);
+    return it != players_.end() ? it->second.position : glm::vec3(0.0f);
+}
+
+void Game::remove_player(uint32_t id) {
+    auto it = players_.find(id);
+    if (it != players_.end() && it->second.udp_slot >= 0) udp_slots_[it->second.udp_slot] = UdpSlot{};
+    players_.erase(id);
+    if (recorder_) recorder_->player_left(tick_count_, id);
+
+    GameMessage msg{};
+    msg.type = MessageType::PlayerLeave;
+    msg.setData(id);
+    broadcast(msg);
+}
+
+void Game::handle_msg(uint32_t sender_id, const GameMessage& msg) {
+    TRACE_SCOPE("Game::handle_msg");
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!players_.count(sender_id)) return;
+    if (msg.type == MessageType::Handshake) { handle_handshake(sender_id, msg); return; }
+    if (msg.type == MessageType::Ping || msg.type == MessageType::Pong) { handle_ping(sender_id, msg); return; }
+    ScopedPhaseTimer timer(metrics_.phase(TickPhase::Input));
+    if (recorder_) recorder_->message(tick_count_, sender_id, msg);
+
+    auto& st = players_.at(sender_id);
+
+    switch (msg.type) {
+        case MessageType::ClientReady: {
+            st.ready = true;
+            LOG_INFO("[Server] Player {} ready.", sender_id);
+        } break;
+
+        case MessageType::ChatMessage: {
+            // Just relay as-is
+            auto chat = msg.getData<ChatMessageData>();
+            broadcast(msg);
+            LOG_INFO("[Chat] Player {}: {}", chat.player_id, chat.text);
+        } break;
+
+        case MessageType::PlayerInput: {
+            // Legacy single-input message: moved immediately, one step per packet
+            if (state_ != GameState::IN_PROGRESS || st.health <= 0) break;
+            constexpr float kStep = 0.1f; // server step per input packet
+            apply_input(st, msg.getData<PlayerInputData>(), kStep);
+        } break;
+
+        case MessageType::PlayerInputFrames: {
+            // Redundant frames: queue the ones we have not seen, tick() applies one per tick
+            const auto d = msg.getData<PlayerInputFramesData>();
+            PlayerInputData frames[MAX_INPUT_FRAMES];
+            const int n = decode_input_frames(d, frames);
+            const bool accept = state_ == GameState::IN_PROGRESS && st.health > 0;
+            if (st.last_input_seq != 0 && d.newest_sequence > st.last_input_seq
+                && d.newest_sequence - st.last_input_seq > kMaxInputSequenceJump) {
+                LOG_WARN("[Server] Player {} input sequence jumped {} -> {}, ignored", sender_id, st.last_input_seq, d.newest_sequence);
+                break;
+            }
+            for (int i = n - 1; i >= 0; --i) {
+                if (static_cast<uint32_t>(i) >= d.newest_sequence) continue; // would wrap below sequence 1
+                const uint32_t seq = d.newest_sequence - static_cast<uint32_t>(i);
+                if (seq <= st.last_input_seq) continue; // duplicate copy
+                st.last_input_seq = seq;
+                if (accept) st.input_queue.push_back(frames[i]);
+            }
+            // Bound the added latency if the client runs ahead of the tick
+            while (st.input_queue.size() > kMaxQueuedInputs) st.input_queue.pop_front();
+        } break;
+
+        case MessageType::PlayerShoot: {
+            if (state_ != GameState::IN_PROGRESS || st.health <= 0) break;
+
+            glm::vec3 f = st.rotation * glm::vec3(0, 0, -1);
+
+            // Broadcast projectile spawn (for visuals)
+            {
+                GameMessage proj{};
+                proj.type = MessageType::ProjectileSpawn;
+                ProjectileData pd{ st.position, f };
+                proj.setData(pd);
+                broadcast(proj);
+            }
+
+            for (auto& [tid, target] : players_) {
+                if (tid == sender_id || target.health <= 0) continue;
+
+                if (hitscan_hits(st.position, f, target.position)) {
+                    target.health -= 25;
+                    GameMessage hit{};
+                    hit.type = MessageType::PlayerHit;
+                    PlayerHitData hd{ tid, sender_id, target.health };
+                    hit.setData(hd);
+                    broadcast(hit);
+
+                    if (target.health <= 0) {
+                        target.deaths++;
+                        st.kills++;
+                        target.death_tick = tick_count_;
+
+                        // Win condition: first to 5 kills
+                        if (st.kills >= 5) {
+                            state_ = GameState::GAME_OVER;
+                            gameover_tick_ = tick_count_;
+                            GameMessage end{};
+                            end.type = MessageType::GameStateUpdate;
+                            GameStateData ed{ state_, sender_id };
+                            end.setData(ed);
+                            broadcast(end);
+                        }
+                    }
+                }
+            }
+        } break;
+
+        default:
+            // ignore unknown/unused here
+            break;
+    }
+}
+
+void Game::apply_input(PlayerRuntime& st, const PlayerInputData& in, float step) {
+    st.rotation = in.rotation;
+
+    // movement
+    glm::vec3 f = st.rotation * glm::vec3(0, 0, -1);
+    glm::vec3 r = st.rotation * glm::vec3(1, 0, 0);
+    glm::vec3 old = st.position;
+
+    if (in.up)    st.position += f * step;
+    if (in.down)  st.position -= f * step;
+    if (in.left)  st.position -= r * step;
+    if (in.right) st.position += r * step;
+
+    st.update_aabb();
+
+    // collide players
+    for (auto& [oid, other] : players_) {
+        if (oid == st.id || other.health <= 0) continue;
+        if (aabb_overlap(st.box, other.box)) {
+            st.position = old;
+            st.update_aabb();
+            break;
+        }
+    }
+    // collide world
+    for (const auto& c : colliders_) {
+        if (aabb_overlap(st.box, c)) {
+            st.position = old;
+            st.update_aabb();
+            break;
+        }
+    }
+}
+
+void Game::tick_loop() {
+    // Game tick @ ~60Hz on absolute deadlines: tick N is due N * kTickInterval after
+    // start(), the clock clients rebuild from Pong. expires_after() would add each
+    // tick's run time and wakeup latency to the schedule and drift from it.
+    last_tick_start_ = next_tick_;
+    tick();
+
+    next_tick_ += kTickInterval;
+    const auto now = std::chrono::steady_clock::now();
+    if (now - next_tick_ > kMaxTickCatchUp) {
+        LOG_WARN("[Server] Tick loop stalled {} ms, rescheduling",
+                 std::chrono::duration_cast<std::chrono::milliseconds>(now - next_tick_).count());
+        next_tick_ = now;
+    }
+    tick_.expires_at(next_tick_);
+    tick_.async_wait([this](const boost::system::error_code&) { tick_loop(); });
+}
+
+void Game::tick() {
+    TRACE_SCOPE("Game::tick");
+    const auto tick_start = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        ++tick_count_;
+
+        {
+            TRACE_SCOPE("simulation");
+            ScopedPhaseTimer sim_timer(metrics_.phase(TickPhase::Simulation));
+            if (state_ == GameState::LOBBY) {
+                if (players_.size() > 1) {
+                    bool all_ready = true;
+                    for (auto& [id, p] : players_) {
+                        if (!p.ready) { all_ready = false; break; }
+                    }
+                    if (all_ready) start_match();
+                }
+            } else if (state_ == GameState::GAME_OVER) {
+                if (tick_count_ - gameover_tick_ >= kGameOverTicks) {
+                    state_ = GameState::LOBBY;
+                    for (auto& [id, p] : players_) p.ready = false;
+
+                    GameMessage gs{};
+                    gs.type = MessageType::GameStateUpdate;
+                    GameStateData sd{ state_, 0 };
+                    gs.setData(sd);
+                    broadcast(gs);
+                }
+            } else if (state_ == GameState::IN_PROGRESS) {
+                // One buffered input frame per player per tick; a late frame repeats the
+                // previous one for a few ticks so a jittery link does not stutter
+                for (auto& [id, p] : players_) {
+                    if (p.health <= 0) { p.input_queue.clear(); continue; }
+                    if (!p.input_queue.empty()) {
+                        p.last_input = p.input_queue.front();
+                        p.input_queue.pop_front();
+                        p.input_starved_ticks = 0;
+                    } else if (p.last_input_seq == 0 || ++p.input_starved_ticks > kMaxRepeatedInputs) {
+                        continue;
+                    }
+                    apply_input(p, p.last_input, kMoveStep);
+                }
+
+                // Handle respawns
+                for (auto& [id, p] : players_) {
+                    if (p.health <= 0) {
+                        if (tick_count_ - p.death_tick >= kRespawnTicks) {
+                            p.health = 100;
+                            p.position = glm::vec3(static_cast<float>(spawn_rng_(rng_)), 0.0f,
+                                                   static_cast<float>(spawn_rng_(rng_)));
+                            p.update_aabb();
+
+                            GameMessage resp{};
+                            resp.type = MessageType::PlayerRespawn;
+                            PlayerRespawnData rd{ id, p.position };
+                            resp.setData(rd);
+                            broadcast(resp);
+                        }
+                    }
+                }
+            }
+        }
+
+        // Send periodic PlayerState (All players) over TCP so clients stay in sync even without UDP
+        GameMessage ps{};
+        {
+            TRACE_SCOPE("replication");
+            ScopedPhaseTimer rep_timer(metrics_.phase(TickPhase::Replication));
+            AllPlayersStateData batch{};
+            batch.count = 0;
+            batch.tick = static_cast<uint32_t>(tick_count_);
+            for (auto& [id, p] : players_) {
+                if (batch.count >= MAX_PLAYERS) break;
+                PlayerStateData d{ p.id, p.position, p.rotation, p.box.min, p.box.max, p.health, p.kills, p.deaths, p.ready };
+                batch.players[batch.count++] = d;
+            }
+            ps.type = MessageType::PlayerState;
+            ps.setData(batch);
+        }
+
+        TRACE_SCOPE("send");
+        ScopedPhaseTimer send_timer(metrics_.phase(TickPhase::Send));
+        broadcast(ps);
+
+        if (tick_count_ % kPingIntervalTicks == 0) {
+            GameMessage ping{};
+            ping.type = MessageType::Ping;
+            ping.setData(PingData{ static_cast<uint32_t>(tick_count_), steady_now_us() });
+            for (auto& slot : udp_slots_) {
+                if (slot.bound) slot.conn->send(Channel::Unreliable, ping);
+            }
+        }
+
+        // One packet per UDP peer: this tick's state, queued events, acks and resends
+        const auto now = std::chrono::steady_clock::now();
+        for (auto& slot : udp_slots_) {
+            if (slot.bound) flush_udp(slot, now);
+        }
+
+        if (recorder_ && tick_count_ % recorder_->keyframe_interval() == 0) {
+            Keyframe kf;
+            kf.tick = tick_count_;
+            kf.state_hash = hash_locked();
+            kf.state = state_;
+            for (const auto& [id, p] : players_)
+                kf.players.push_back({ p.id, p.position, p.rotation, p.box.min, p.box.max, p.health, p.kills, p.deaths, p.ready });
+            std::sort(kf.players.begin(), kf.players.end(),
+                      [](const PlayerStateData& a, const PlayerStateData& b) { return a.id < b.id; });
+            recorder_->keyframe(kf);
+        }
+    }
+    metrics_.record_tick(std::chrono::steady_clock::now() - tick_start);
+}
+
+void Game::do_receive_udp() {
+    udp_socket_.async_receive_from(
+        boost::asio::buffer(udp_buf_), udp_remote_,
+        [this](boost::system::error_code ec, std::size_t bytes) {
+            if (!ec) {
+                TRACE_SCOPE("Game::receive_udp");
+                metrics_.udp_in(bytes);
+                UdpHeader h{};
+                if (!read_udp_header(udp_buf_.data(), bytes, h) || h.slot >= udp_slots_.size()) {
+                    metrics_.udp_drop();
+                } else {
+                    uint32_t sender = 0;
+                    udp_inbox_.clear();
+                    {
+                        std::lock_guard<std::mutex> lock(mtx_);
+                        UdpSlot& slot = udp_slots_[h.slot];
+                        if (!slot.active || slot.token != h.token) {
+                            metrics_.udp_drop();
+                        } else {
+                            if (!slot.bound || slot.endpoint != udp_remote_) {
+                                // First datagram binds the endpoint; a valid token may rebind it (NAT rebinding)
+                                slot.endpoint = udp_remote_;
+                                slot.bound = true;
+                            }
+                            sender = slot.player_id;
+                            if (slot.stats) slot.stats->udp.add_in(bytes);
+                            const bool ok = slot.conn->read_packet(
+                                udp_buf_.data() + sizeof(UdpHeader), bytes - sizeof(UdpHeader),
+                                std::chrono::steady_clock::now(),
+                                [this](const GameMessage& m) {
+                                    metrics_.message_in(m.type, sizeof(ChannelMessageHeader) + message_wire_size(m),
+                                                        Metrics::Transport::Udp);
+                                    udp_inbox_.push_back(m);
+                                });
+                            if (!ok) metrics_.udp_drop();
+                        }
+                    }
+                    // handle_msg takes the lock itself
+                    for (const GameMessage& m : udp_inbox_) handle_msg(sender, m);
+                }
+            }
+            do_receive_udp();
+        }
+    );
+}
+
+void Game::flush_udp(UdpSlot& slot, std::chrono::steady_clock::time_point now) {
+    auto buffers = slot.send_buffers;
+    const std::size_t index = buffers->next;
+    if (buffers->in_flight[index]) {
+        // Every buffer still sending: leave the queued messages for the next flush
+        metrics_.udp_send_deferred();
+        return;
+    }
+    buffers->next = (index + 1) % UdpSlot::SendBuffers::kCount;
+    while (!slot.ordered_overflow.empty() && slot.conn->send(Channel::ReliableOrdered, slot.ordered_overflow.front()))
+        slot.ordered_overflow.pop_front();
+    char* data = buffers->data[index].data();
+    const std::size_t size = slot.conn->write_packet(now, data, kMaxPacketSize, [this](MessageType type, std::size_t bytes) {
+        metrics_.message_out(type, bytes, Metrics::Transport::Udp);
+    });
+    if (slot.stats) slot.stats->reliable_window.store(slot.conn->reliable_in_flight(), std::memory_order_relaxed);
+    buffers->in_flight[index] = true;
+    udp_socket_.async_send_to(
+        boost::asio::buffer(data, size),
+        slot.endpoint,
+        [this, buffers, index, stats = slot.stats](boost::system::error_code ec, std::size_t n) {
+            buffers->in_flight[index] = false;
+            if (ec) { metrics_.udp_send_error(); return; }
+            metrics_.udp_out(n);
+            if (stats) stats->udp.add_out(n);
+        });
+}
+
+void Game::broadcast(const GameMessage& msg) {
+    TRACE_SCOPE("Game::broadcast");
+    for (auto& [id, s] : sessions_) send_to(id, msg);
+}
+
+void Game::send_to(uint32_t id, const GameMessage& msg) {
+    Channel ch;
+    auto p = players_.find(id);
+    if (p != players_.end() && p->second.udp_slot >= 0 && udp_channel_for(msg.type, ch)) {
+        UdpSlot& slot = udp_slots_[p->second.udp_slot];
+        if (slot.bound && ch == Channel::ReliableOrdered && (!slot.ordered_overflow.empty() || !slot.conn->send(ch, msg))) {
+            // One ordered stream, one transport: wait for the window (flush_udp) instead of TCP
+            if (slot.ordered_overflow.size() < kMaxOrderedOverflow) slot.ordered_overflow.push_back(msg);
+            else LOG_WARN("[Server] Player {} ordered UDP backlog full, dropped {}", id, message_type_name(msg.type));
+            return;
+        }
+        // Queued for this tick's packet; a full unordered window falls back to TCP
+        if (slot.bound && slot.conn->send(ch, msg)) return;
+    }
+    auto it = sessions_.find(id);
+    if (it != sessions_.end()) it->second->deliver(msg);
+}
+
+void Game::start_match() {
+    state_ = GameState::IN_PROGRESS;
+    reset_match();
+    GameMessage gs{};
+    gs.type = MessageType::GameStateUpdate;
+    GameStateData sd{ state_, 0 };
+    gs.setData(sd);
+    broadcast(gs);
+    LOG_INFO("[Server] Match started.");
+}
+
+void Game::reset_match() {
+    for (auto& [id, p] : players_) {
+        p.health = 100;
+        p.kills = 0;
+        p.deaths = 0;
+        p.position = glm::vec3(static_cast<float>(spawn_rng_(rng_)), 0.0f,
+                               static_cast<float>(spawn_rng_(rng_)));
+        p.update_aabb();
+    }
+}
+
+// ---------------------- Determinism / recording ----------------------
+
+void Game::reseed(uint32_t seed) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    seed_ = seed;
+    rng_.seed(seed);
+}
+
+void Game::set_recorder(MatchRecorder* recorder) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    recorder_ = recorder;
+}
+
+uint64_t Game::state_hash() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return hash_locked();
+}
+
+uint64_t Game::hash_locked() const {
+    uint64_t h = 1469598103934665603ull; // FNV-1a offset basis
+    auto mix = [&h](const void* p, std::size_t n) {
+        const auto* b = static_cast<const uint8_t*>(p);
+        for (std::size_t i = 0; i < n; ++i) { h ^= b[i]; h *= 1099511628211ull; }
+    };
+
+    mix(&tick_count_, sizeof(tick_count_));
+    mix(&state_, sizeof(state_));
+
+    std::vector<const PlayerRuntime*> sorted;
+    sorted.reserve(players_.size());
+    for (const auto& [id, p] : players_) sorted.push_back(&p);
+    std::sort(sorted.begin(), sorted.end(),
+              [](const PlayerRuntime* a, const PlayerRuntime* b) { return a->id < b->id; });
+
+    for (const PlayerRuntime* p : sorted) {
+        mix(&p->id, sizeof(p->id));
+        mix(&p->position, sizeof(p->position));
+        mix(&p->rotation, sizeof(p->rotation));
+        mix(&p->health, sizeof(p->health));
+        mix(&p->kills, sizeof(p->kills));
+        mix(&p->deaths, sizeof(p->deaths));
+        const uint8_t ready = p->ready ? 1 : 0;
+        mix(&ready, sizeof(ready));
+    }
+    return h;
+}
@@ -0,0 +1,247 @@
+// Game.h
+// Authoritative game core: TCP sessions, UDP state stream and the 60Hz tick.
+
+#pragma once
+
+#include <boost/asio.hpp>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "../shared/protocol.h"
+#include "../shared/clock_sync.h"
+#include "../shared/reliable_udp.h"
+#include "Collision.h"
+#include "Metrics.h"
+
+using boost::asio::ip::tcp;
+using boost::asio::ip::udp;
+
+// Server tick interval (~60Hz); also the budget reported by Metrics
+constexpr std::chrono::milliseconds kTickInterval{16};
+static_assert(std::chrono::microseconds(kTickInterval).count() == SERVER_TICK_US, "clients assume SERVER_TICK_US");
+// Missed ticks are run back to back up to this far behind; past it the schedule restarts
+// from now, which clients see as a server restart (ClockSync's one-second threshold)
+constexpr std::chrono::seconds kMaxTickCatchUp{1};
+
+// Movement per applied input frame; matches the client's predicted 2.5 units/s
+constexpr float kMoveStep = 2.5f * std::chrono::duration<float>(kTickInterval).count();
+constexpr std::size_t kMaxQueuedInputs = 4;   // frames buffered ahead of the tick
+constexpr int kMaxRepeatedInputs = 4;         // ticks the last frame is reused while starved
+// Furthest a PlayerInputFrames sequence may run ahead of the last one seen (30 s of
+// frames); anything beyond is not a lost-packet gap but a bogus or wrapped counter
+constexpr uint32_t kMaxInputSequenceJump = 30 * 1000000 / SERVER_TICK_US;
+
+// Timers are counted in ticks so the simulation replays identically from a recording
+constexpr uint64_t kRespawnTicks = std::chrono::milliseconds(std::chrono::seconds(5)) / kTickInterval;
+constexpr uint64_t kGameOverTicks = std::chrono::milliseconds(std::chrono::seconds(10)) / kTickInterval;
+
+// Server-initiated Ping to every UDP peer, for per-session RTT
+constexpr uint64_t kPingIntervalTicks = 30;
+constexpr std::size_t kMaxOrderedOverflow = 64; // ReliableOrdered messages held while a peer's window is full
+
+// ---------------------- Game data structures ----------------------
+
+struct PlayerRuntime {
+    uint32_t id = 0;
+    glm::vec3 position{0.0f, 0.0f, 3.0f};
+    glm::quat rotation{1, 0, 0, 0};
+    AABB box{};
+    int health = 100;
+    int kills = 0;
+    int deaths = 0;
+    bool ready = false;
+    int udp_slot = -1; // index into Game::udp_slots_ once the handshake succeeded
+
+    // Redundant input (PlayerInputFrames): newest sequence seen and frames awaiting a tick
+    uint32_t last_input_seq = 0;
+    std::deque<PlayerInputData> input_queue;
+    PlayerInputData last_input{};
+    int input_starved_ticks = 0;
+
+    uint64_t death_tick = 0;
+
+    RttEstimator rtt; // from Pongs to our Pings; not part of the simulation
+
+    void update_aabb() {
+        // Match your client’s debug bbox ~ 1x2x1 around center
+        glm::vec3 half(0.5f, 1.0f, 0.5f);
+        box.min = position - half;
+        box.max = position + half;
+    }
+};
+
+// One handshaken UDP peer. Datagrams name their slot directly; the token rejects
+// stale or spoofed packets before any other work is done.
+struct UdpSlot {
+    bool active = false;   // issued by a handshake
+    bool bound = false;    // endpoint learned from the first valid datagram
+    uint32_t player_id = 0;
+    uint32_t token = 0;
+    udp::endpoint endpoint;
+    std::unique_ptr<ReliableEndpoint> conn; // sequencing, acks and channels for this peer
+    std::shared_ptr<SessionStats> stats;    // the player's session, if it has one
+    // ReliableOrdered messages that did not fit the window, oldest first. They wait here
+    // rather than going over TCP, which could deliver them ahead of earlier ones.
+    std::deque<GameMessage> ordered_overflow;
+
+    // Outgoing datagrams, reused round robin instead of allocated per send. A buffer
+    // stays in_flight until its async send completes (on the io thread, like the tick);
+    // the handler holds a reference so a send outlives a slot reset.
+    struct SendBuffers {
+        static constexpr std::size_t kCount = 4;
+        std::array<std::array<char, kMaxPacketSize>, kCount> data;
+        std::array<bool, kCount> in_flight{};
+        std::size_t next = 0;
+    };
+    std::shared_ptr<SendBuffers> send_buffers;
+};
+
+// Forward declarations
+class Game;
+class Session;
+class MatchRecorder;
+
+// ---------------------- Session: one TCP client ----------------------
+
+class Session : public std::enable_shared_from_this<Session> {
+public:
+    Session(tcp::socket socket, Game& game) : socket_(std::move(socket)), game_(game) {}
+
+    void start();
+    void deliver(const GameMessage& msg); // thread-safe: called from Game under lock
+
+    uint32_t id() const { return id_; }
+    void set_id(uint32_t v) { id_ = v; }
+    void set_stats(std::shared_ptr<SessionStats> stats) { stats_ = std::move(stats); }
+    SessionStats* stats() const { return stats_.get(); }
+    const std::shared_ptr<SessionStats>& stats_ptr() const { return stats_; }
+
+private:
+    void read_header();
+    void read_body(std::size_t body_len);
+    void write_next();
+
+    tcp::socket socket_;
+    Game& game_;
+
+    // TCP length-prefixed header (4 bytes)
+    enum { header_len = sizeof(uint32_t) };
+    std::array<char, header_len> header_buf_{};
+    std::vector<char> body_buf_;
+
+    std::deque<std::vector<char>> write_q_;
+    uint32_t id_ = 0;
+    std::shared_ptr<SessionStats> stats_;
+};
+
+// ---------------------- Game core ----------------------
+
+class Game {
+public:
+    // Port 0 binds an ephemeral port (benchmarks, tools).
+    explicit Game(boost::asio::io_context& io,
+                  unsigned short tcp_port = TCP_PORT,
+                  unsigned short udp_port = UDP_PORT);
+
+    // Starts accepting clients and the tick timer. Tools that drive tick() by hand skip this.
+    void start();
+
+    // Session lifecycle
+    void join(const std::shared_ptr<Session>& s);
+    void leave(const std::shared_ptr<Session>& s);
+
+    // Adds a player that has no network session (benchmarks, tools); returns its id.
+    // id 0 allocates the next free id.
+    uint32_t add_local_player(uint32_t id = 0);
+    void remove_local_player(uint32_t id);
+    // Moves a player without telling anyone (not broadcast, not recorded); benchmarks
+    // use it to start players clear of colliders. False if there is no such player.
+    bool place_player(uint32_t id, const glm::vec3& position);
+    glm::vec3 player_position(uint32_t id);
+
+    // Incoming gameplay messages
+    void handle_msg(uint32_t sender_id, const GameMessage& msg);
+
+    // One simulation step; tick_loop() calls this every kTickInterval
+    void tick();
+
+    GameState state() const { return state_; }
+    Metrics& metrics() { return metrics_; }
+
+    // Determinism / recording
+    uint32_t seed() const { return seed_; }
+    void reseed(uint32_t seed); // call before any player joins
+    uint64_t tick_count() const { return tick_count_; }
+    uint64_t state_hash();      // FNV-1a over game state and all players, in id order
+    void set_recorder(MatchRecorder* recorder); // nullptr stops recording
+
+private:
+    // Loop
+    void tick_loop();
+
+    // Networking
+    void do_accept();
+    void do_receive_udp();
+
+    // Broadcasts (caller must hold lock). Real-time messages use the player's
+    // UDP channels once bound (udp_channel_for), everything else goes over TCP.
+    void broadcast(const GameMessage& msg);
+    void send_to(uint32_t id, const GameMessage& msg);
+    void flush_udp(UdpSlot& slot, std::chrono::steady_clock::time_point now);
+
+    // Game helpers (caller must hold lock)
+    void handle_handshake(uint32_t sender_id, const GameMessage& msg);
+    void handle_ping(uint32_t sender_id, const GameMessage& msg);
+    PlayerRuntime& spawn_player(uint32_t id);
+    void apply_input(PlayerRuntime& st, const PlayerInputData& in, float step);
+    void remove_player(uint32_t id);
+    uint64_t hash_locked() const;
+    void start_match();
+    void reset_match();
+
+private:
+    boost::asio::io_context& io_;
+    tcp::acceptor acceptor_;
+    udp::socket udp_socket_;
+    udp::endpoint udp_remote_;
+    std::array<char, 1536> udp_buf_{};
+    std::vector<GameMessage> udp_inbox_; // messages from one datagram, handled after unlocking
+
+    boost::asio::steady_timer tick_;
+
+    std::mutex mtx_;
+    std::unordered_map<uint32_t, std::shared_ptr<Session>> sessions_;
+    std::unordered_map<uint32_t, PlayerRuntime> players_;
+    std::array<UdpSlot, MAX_PLAYERS> udp_slots_{};
+
+    GameState state_ = GameState::LOBBY;
+    uint32_t next_id_ = 1;
+    uint64_t tick_count_ = 0;
+    uint64_t gameover_tick_ = 0;
+    std::chrono::steady_clock::time_point next_tick_{};       // deadline of the next tick_loop()
+    std::chrono::steady_clock::time_point last_tick_start_{}; // scheduled, not actual: for Pong tick_age_us
+
+    // World
+    std::vector<AABB> colliders_;
+
+    // RNG for spawn points; seeded explicitly so recordings replay
+    uint32_t seed_;
+    std::mt19937 rng_;
+    std::uniform_int_distribution<int> spawn_rng_;
+
+    // UDP tokens; separate from rng_ so handshakes never perturb the simulation
+    std::mt19937 token_rng_;
+
+    Metrics metrics_{kTickInterval};
+    MatchRecorder* recorder_ = nullptr;
+};
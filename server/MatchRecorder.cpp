@@ -0,0 +1,202 @@
+// MatchRecorder.cpp
+// Recording encoder/writer thread and the replay reader (see MatchRecorder.h).
+
+#include "MatchRecorder.h"
+
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+
+constexpr char kMagic[4] = { 'G', 'R', 'E', 'C' };
+
+// Hand buffered records to the writer once this much has accumulated between keyframes
+constexpr std::size_t kFlushThreshold = 64 * 1024;
+
+} // namespace
+
+// ====================== MatchRecorder ======================
+
+MatchRecorder::MatchRecorder(const std::string& path, const RecordingHeader& header)
+    : out_(path, std::ios::binary | std::ios::trunc),
+      keyframe_interval_(header.keyframe_interval) {
+    if (!out_) throw std::runtime_error("could not create recording " + path);
+
+    put_bytes(kMagic, sizeof(kMagic));
+    uint16_t version = kRecordingVersion, reserved = 0;
+    put_bytes(&version, sizeof(version));
+    put_bytes(&reserved, sizeof(reserved));
+    put_bytes(&header.seed, sizeof(header.seed));
+    put_bytes(&header.tick_interval_us, sizeof(header.tick_interval_us));
+    put_bytes(&header.keyframe_interval, sizeof(header.keyframe_interval));
+    flush_pending();
+
+    writer_ = std::thread([this] { writer_loop(); });
+}
+
+MatchRecorder::~MatchRecorder() {
+    flush_pending();
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    writer_.join();
+}
+
+void MatchRecorder::player_joined(uint64_t tick, uint32_t player_id) {
+    begin_record(RecordKind::Join, tick);
+    put_varint(player_id);
+}
+
+void MatchRecorder::player_left(uint64_t tick, uint32_t player_id) {
+    begin_record(RecordKind::Leave, tick);
+    put_varint(player_id);
+}
+
+void MatchRecorder::message(uint64_t tick, uint32_t player_id, const GameMessage& msg) {
+    begin_record(RecordKind::Message, tick);
+    put_varint(player_id);
+    put_u8(static_cast<uint8_t>(msg.type));
+    put_bytes(msg.data, message_payload_size(msg.type));
+    if (pending_.size() >= kFlushThreshold) flush_pending();
+}
+
+void MatchRecorder::keyframe(const Keyframe& kf) {
+    begin_record(RecordKind::Keyframe, kf.tick);
+    put_bytes(&kf.state_hash, sizeof(kf.state_hash));
+    put_u8(static_cast<uint8_t>(kf.state));
+    put_varint(kf.players.size());
+    put_bytes(kf.players.data(), kf.players.size() * sizeof(PlayerStateData));
+    flush_pending();
+}
+
+void MatchRecorder::begin_record(RecordKind kind, uint64_t tick) {
+    put_u8(static_cast<uint8_t>(kind));
+    put_varint(tick - last_tick_);
+    last_tick_ = tick;
+}
+
+void MatchRecorder::put_varint(uint64_t v) {
+    while (v >= 0x80) {
+        pending_.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    pending_.push_back(static_cast<uint8_t>(v));
+}
+
+void MatchRecorder::put_bytes(const void* p, std::size_t n) {
+    const auto* b = static_cast<const uint8_t*>(p);
+    pending_.insert(pending_.end(), b, b + n);
+}
+
+void MatchRecorder::flush_pending() {
+    if (pending_.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        ready_.insert(ready_.end(), pending_.begin(), pending_.end());
+    }
+    pending_.clear();
+    cv_.notify_one();
+}
+
+void MatchRecorder::writer_loop() {
+    std::vector<uint8_t> batch;
+    for (;;) {
+        bool stop = false;
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            cv_.wait(lock, [this] { return stopping_ || !ready_.empty(); });
+            batch.swap(ready_);
+            stop = stopping_;
+        }
+        if (!batch.empty()) {
+            out_.write(reinterpret_cast<const char*>(batch.data()), static_cast<std::streamsize>(batch.size()));
+            out_.flush();
+            batch.clear();
+        }
+        if (stop) return;
+    }
+}
+
+// ====================== RecordingReader ======================
+
+RecordingReader::RecordingReader(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("could not open recording " + path);
+    data_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+    char magic[4];
+    uint16_t version = 0, reserved = 0;
+    need_bytes(magic, sizeof(magic));
+    if (std::memcmp(magic, kMagic, sizeof(magic)) != 0) throw std::runtime_error("not a match recording: " + path);
+    need_bytes(&version, sizeof(version));
+    if (version != kRecordingVersion) throw std::runtime_error("unsupported recording version");
+    need_bytes(&reserved, sizeof(reserved));
+    need_bytes(&header_.seed, sizeof(header_.seed));
+    need_bytes(&header_.tick_interval_us, sizeof(header_.tick_interval_us));
+    need_bytes(&header_.keyframe_interval, sizeof(header_.keyframe_interval));
+}
+
+bool RecordingReader::next(Record& out) {
+    uint8_t kind = 0;
+    if (!get_u8(kind)) return false;
+
+    out.kind = static_cast<RecordKind>(kind);
+    last_tick_ += need_varint();
+    out.tick = last_tick_;
+
+    switch (out.kind) {
+        case RecordKind::Join:
+        case RecordKind::Leave:
+            out.player_id = static_cast<uint32_t>(need_varint());
+            break;
+        case RecordKind::Message: {
+            out.player_id = static_cast<uint32_t>(need_varint());
+            out.message = GameMessage{};
+            out.message.type = static_cast<MessageType>(need_u8());
+            need_bytes(out.message.data, message_payload_size(out.message.type));
+        } break;
+        case RecordKind::Keyframe: {
+            out.keyframe.tick = out.tick;
+            need_bytes(&out.keyframe.state_hash, sizeof(out.keyframe.state_hash));
+            out.keyframe.state = static_cast<GameState>(need_u8());
+            uint64_t count = need_varint();
+            if (count > MAX_PLAYERS * 64) throw std::runtime_error("corrupt keyframe");
+            out.keyframe.players.resize(static_cast<std::size_t>(count));
+            need_bytes(out.keyframe.players.data(), out.keyframe.players.size() * sizeof(PlayerStateData));
+        } break;
+        default:
+            throw std::runtime_error("corrupt recording: unknown record kind");
+    }
+    return true;
+}
+
+bool RecordingReader::get_u8(uint8_t& v) {
+    if (pos_ >= data_.size()) return false;
+    v = data_[pos_++];
+    return true;
+}
+
+uint8_t RecordingReader::need_u8() {
+    uint8_t v = 0;
+    if (!get_u8(v)) throw std::runtime_error("truncated recording");
+    return v;
+}
+
+uint64_t RecordingReader::need_varint() {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t b = need_u8();
+        v |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if (!(b & 0x80)) return v;
+    }
+    throw std::runtime_error("corrupt varint in recording");
+}
+
+void RecordingReader::need_bytes(void* p, std::size_t n) {
+    if (data_.size() - pos_ < n) throw std::runtime_error("truncated recording");
+    std::memcpy(p, data_.data() + pos_, n);
+    pos_ += n;
+}
@@ -0,0 +1,116 @@
+// MatchRecorder.h
+// Compact append-only match recording: every accepted join/leave/command tagged with
+// its tick, plus periodic keyframes carrying the full player state and a state hash.
+//
+// File layout (little-endian):
+//   header  "GREC" u16 version, u16 reserved, u32 seed, u32 tick_interval_us, u32 keyframe_interval
+//   records u8 kind, varint tick_delta, then per kind:
+//     Join / Leave  varint player_id
+//     Message       varint player_id, u8 type, payload (message_payload_size(type) bytes)
+//     Keyframe      u64 state_hash, u8 game_state, varint count, count * PlayerStateData
+//
+// Records are encoded into memory on the tick thread and written to disk by a
+// background thread, so recording never blocks the simulation on file IO.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../shared/protocol.h"
+
+constexpr uint16_t kRecordingVersion = 1;
+
+enum class RecordKind : uint8_t {
+    Join = 1,
+    Leave = 2,
+    Message = 3,
+    Keyframe = 4
+};
+
+struct RecordingHeader {
+    uint32_t seed = 0;
+    uint32_t tick_interval_us = 0;
+    uint32_t keyframe_interval = 0;
+};
+
+struct Keyframe {
+    uint64_t tick = 0;
+    uint64_t state_hash = 0;
+    GameState state = GameState::LOBBY;
+    std::vector<PlayerStateData> players;
+};
+
+// One decoded record; which fields are meaningful depends on kind
+struct Record {
+    RecordKind kind = RecordKind::Join;
+    uint64_t tick = 0;
+    uint32_t player_id = 0;
+    GameMessage message{};
+    Keyframe keyframe;
+};
+
+class MatchRecorder {
+public:
+    // Throws std::runtime_error if the file cannot be created
+    MatchRecorder(const std::string& path, const RecordingHeader& header);
+    ~MatchRecorder();
+
+    MatchRecorder(const MatchRecorder&) = delete;
+    MatchRecorder& operator=(const MatchRecorder&) = delete;
+
+    uint32_t keyframe_interval() const { return keyframe_interval_; }
+
+    // Called by Game under its lock, in simulation order
+    void player_joined(uint64_t tick, uint32_t player_id);
+    void player_left(uint64_t tick, uint32_t player_id);
+    void message(uint64_t tick, uint32_t player_id, const GameMessage& msg);
+    void keyframe(const Keyframe& kf); // also hands buffered records to the writer
+
+private:
+    void begin_record(RecordKind kind, uint64_t tick);
+    void put_u8(uint8_t v) { pending_.push_back(v); }
+    void put_varint(uint64_t v);
+    void put_bytes(const void* p, std::size_t n);
+    void flush_pending();
+    void writer_loop();
+
+    std::ofstream out_;
+    uint32_t keyframe_interval_;
+    uint64_t last_tick_ = 0;
+    std::vector<uint8_t> pending_; // tick thread only
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::vector<uint8_t> ready_;   // guarded by mtx_
+    bool stopping_ = false;
+    std::thread writer_;
+};
+
+// Sequential reader for replay
+class RecordingReader {
+public:
+    // Throws std::runtime_error on a missing file or bad header
+    explicit RecordingReader(const std::string& path);
+
+    const RecordingHeader& header() const { return header_; }
+
+    // False at end of file; throws std::runtime_error on a truncated or corrupt record
+    bool next(Record& out);
+
+private:
+    bool get_u8(uint8_t& v);
+    uint8_t need_u8();
+    uint64_t need_varint();
+    void need_bytes(void* p, std::size_t n);
+
+    std::vector<uint8_t> data_;
+    std::size_t pos_ = 0;
+    RecordingHeader header_;
+    uint64_t last_tick_ = 0;
+};
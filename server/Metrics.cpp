@@ -0,0 +1,258 @@
+// Metrics.cpp
+// Histogram bucketing and Prometheus exposition (see Metrics.h).
+
+#include "Metrics.h"
+
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+int msb64(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(v);
+#else
+    int m = 0;
+    while (v >>= 1) ++m;
+    return m;
+#endif
+}
+
+void atomic_max(std::atomic<uint64_t>& a, uint64_t v) {
+    uint64_t cur = a.load(std::memory_order_relaxed);
+    while (v > cur && !a.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+}
+
+double seconds(uint64_t ns) { return static_cast<double>(ns) * 1e-9; }
+
+} // namespace
+
+// ---------------------- Histogram ----------------------
+
+std::size_t Histogram::bucket_index(uint64_t v) {
+    if (v < kSubCount) return static_cast<std::size_t>(v);
+    int m = msb64(v);
+    if (m > kMaxMsb) return kBucketCount - 1;
+    uint64_t group = static_cast<uint64_t>(m - kSubBits + 1);
+    uint64_t sub = (v >> (m - kSubBits)) - kSubCount;
+    return static_cast<std::size_t>(group * kSubCount + sub);
+}
+
+uint64_t Histogram::bucket_lower(std::size_t index) {
+    uint64_t group = index / kSubCount;
+    uint64_t sub = index % kSubCount;
+    if (group == 0) return sub;
+    return (kSubCount + sub) << (group - 1);
+}
+
+void Histogram::record(uint64_t value_ns) {
+    buckets_[bucket_index(value_ns)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value_ns, std::memory_order_relaxed);
+    atomic_max(max_, value_ns);
+}
+
+uint64_t Histogram::percentile(double q) const {
+    uint64_t total = count();
+    if (total == 0) return 0;
+    uint64_t target = static_cast<uint64_t>(std::ceil(q * static_cast<double>(total)));
+    if (target == 0) target = 1;
+
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            uint64_t lo = bucket_lower(i);
+            uint64_t width = (i < kSubCount) ? 1 : (1ull << (i / kSubCount - 1));
+            return lo + width / 2;
+        }
+    }
+    return max();
+}
+
+// ---------------------- SessionStats ----------------------
+
+void SessionStats::set_write_queue_depth(std::size_t depth) {
+    write_queue_depth.store(depth, std::memory_order_relaxed);
+    atomic_max(write_queue_max, depth);
+}
+
+// ---------------------- Metrics ----------------------
+
+const char* tick_phase_name(TickPhase p) {
+    switch (p) {
+        case TickPhase::Input:       return "input";
+        case TickPhase::Simulation:  return "simulation";
+        case TickPhase::Replication: return "replication";
+        case TickPhase::Send:        return "send";
+        case TickPhase::Total:       return "total";
+        case TickPhase::Count:       break;
+    }
+    return "unknown";
+}
+
+void Metrics::record_tick(std::chrono::nanoseconds total) {
+    ticks_.fetch_add(1, std::memory_order_relaxed);
+    if (total > tick_budget_) tick_overruns_.fetch_add(1, std::memory_order_relaxed);
+    phase(TickPhase::Total).record(static_cast<uint64_t>(total.count()));
+}
+
+std::shared_ptr<SessionStats> Metrics::register_session(uint32_t player_id) {
+    auto stats = std::make_shared<SessionStats>(player_id);
+    std::lock_guard<std::mutex> lock(sessions_mtx_);
+    sessions_[player_id] = stats;
+    return stats;
+}
+
+void Metrics::unregister_session(uint32_t player_id) {
+    std::lock_guard<std::mutex> lock(sessions_mtx_);
+    sessions_.erase(player_id);
+}
+
+std::string Metrics::render_prometheus() const {
+    std::ostringstream os;
+    auto load = [](const std::atomic<uint64_t>& a) { return a.load(std::memory_order_relaxed); };
+
+    os << "# HELP game_tick_phase_seconds Duration of each server tick phase.\n"
+       << "# TYPE game_tick_phase_seconds summary\n";
+    for (std::size_t i = 0; i < phases_.size(); ++i) {
+        const Histogram& h = phases_[i];
+        const char* name = tick_phase_name(static_cast<TickPhase>(i));
+        for (double q : { 0.5, 0.9, 0.99, 0.999 }) {
+            os << "game_tick_phase_seconds{phase=\"" << name << "\",quantile=\"" << q << "\"} "
+               << seconds(h.percentile(q)) << "\n";
+        }
+        os << "game_tick_phase_seconds_sum{phase=\"" << name << "\"} " << seconds(h.sum()) << "\n"
+           << "game_tick_phase_seconds_count{phase=\"" << name << "\"} " << h.count() << "\n";
+    }
+
+    os << "# HELP game_tick_phase_max_seconds Longest observed duration of each tick phase.\n"
+       << "# TYPE game_tick_phase_max_seconds gauge\n";
+    for (std::size_t i = 0; i < phases_.size(); ++i) {
+        os << "game_tick_phase_max_seconds{phase=\"" << tick_phase_name(static_cast<TickPhase>(i)) << "\"} "
+           << seconds(phases_[i].max()) << "\n";
+    }
+
+    os << "# HELP game_tick_budget_seconds Configured tick interval.\n"
+       << "# TYPE game_tick_budget_seconds gauge\n"
+       << "game_tick_budget_seconds " << seconds(static_cast<uint64_t>(tick_budget_.count())) << "\n"
+       << "# HELP game_ticks_total Ticks executed.\n"
+       << "# TYPE game_ticks_total counter\n"
+       << "game_ticks_total " << load(ticks_) << "\n"
+       << "# HELP game_tick_overruns_total Ticks that took longer than the tick budget.\n"
+       << "# TYPE game_tick_overruns_total counter\n"
+       << "game_tick_overruns_total " << load(tick_overruns_) << "\n";
+
+    os << "# HELP game_rtt_seconds Ping/Pong round-trip time over UDP, all sessions.\n"
+       << "# TYPE game_rtt_seconds summary\n";
+    for (double q : { 0.5, 0.9, 0.99 }) {
+        os << "game_rtt_seconds{quantile=\"" << q << "\"} " << seconds(rtt_.percentile(q)) << "\n";
+    }
+    os << "game_rtt_seconds_sum " << seconds(rtt_.sum()) << "\n"
+       << "game_rtt_seconds_count " << rtt_.count() << "\n";
+
+    os << "# HELP game_connected_players Players with an open session.\n"
+       << "# TYPE game_connected_players gauge\n"
+       << "game_connected_players " << load(connected_players_) << "\n";
+
+    // Traffic by transport and message type; only types that have been seen
+    struct Series { const char* metric; const char* help; std::atomic<uint64_t> TrafficCounters::*field; };
+    struct TypeSeries : Series { Transport via; };
+    const TypeSeries type_series[] = {
+        { { "game_tcp_messages_in_total",  "TCP messages received, by type.",              &TrafficCounters::messages_in }, Transport::Tcp },
+        { { "game_tcp_bytes_in_total",     "TCP bytes received (header included), by type.", &TrafficCounters::bytes_in }, Transport::Tcp },
+        { { "game_tcp_messages_out_total", "TCP messages queued for send, by type.",       &TrafficCounters::messages_out }, Transport::Tcp },
+        { { "game_tcp_bytes_out_total",    "TCP bytes queued for send (header included), by type.", &TrafficCounters::bytes_out }, Transport::Tcp },
+        { { "game_udp_messages_in_total",  "Messages received over UDP, by type.",          &TrafficCounters::messages_in }, Transport::Udp },
+        { { "game_udp_message_bytes_in_total",  "UDP message bytes received (channel header included), by type.", &TrafficCounters::bytes_in }, Transport::Udp },
+        { { "game_udp_messages_out_total", "Messages written to UDP packets (resends included), by type.", &TrafficCounters::messages_out }, Transport::Udp },
+        { { "game_udp_message_bytes_out_total", "UDP message bytes written (channel header included), by type.", &TrafficCounters::bytes_out }, Transport::Udp },
+    };
+    for (const auto& s : type_series) {
+        const auto& by_type = by_type_[static_cast<std::size_t>(s.via)];
+        os << "# HELP " << s.metric << " " << s.help << "\n"
+           << "# TYPE " << s.metric << " counter\n";
+        for (std::size_t t = 0; t < by_type.size(); ++t) {
+            uint64_t v = load(by_type[t].*s.field);
+            if (v == 0) continue;
+            os << s.metric << "{type=\"" << message_type_name(static_cast<MessageType>(t)) << "\"} " << v << "\n";
+        }
+    }
+
+    os << "# HELP game_udp_datagrams_in_total UDP datagrams received.\n"
+       << "# TYPE game_udp_datagrams_in_total counter\n"
+       << "game_udp_datagrams_in_total " << load(udp_.messages_in) << "\n"
+       << "# HELP game_udp_bytes_in_total UDP bytes received.\n"
+       << "# TYPE game_udp_bytes_in_total counter\n"
+       << "game_udp_bytes_in_total " << load(udp_.bytes_in) << "\n"
+       << "# HELP game_udp_datagrams_out_total UDP datagrams sent.\n"
+       << "# TYPE game_udp_datagrams_out_total counter\n"
+       << "game_udp_datagrams_out_total " << load(udp_.messages_out) << "\n"
+       << "# HELP game_udp_bytes_out_total UDP bytes sent.\n"
+       << "# TYPE game_udp_bytes_out_total counter\n"
+       << "game_udp_bytes_out_total " << load(udp_.bytes_out) << "\n"
+       << "# HELP game_udp_drops_total UDP datagrams dropped as malformed or unknown.\n"
+       << "# TYPE game_udp_drops_total counter\n"
+       << "game_udp_drops_total " << load(udp_drops_) << "\n"
+       << "# HELP game_udp_send_errors_total UDP sends that completed with an error.\n"
+       << "# TYPE game_udp_send_errors_total counter\n"
+       << "game_udp_send_errors_total " << load(udp_send_errors_) << "\n"
+       << "# HELP game_udp_sends_deferred_total UDP flushes put off because every send buffer was still in flight.\n"
+       << "# TYPE game_udp_sends_deferred_total counter\n"
+       << "game_udp_sends_deferred_total " << load(udp_send_deferred_) << "\n";
+
+    // Per-session series
+    std::vector<std::shared_ptr<SessionStats>> sessions;
+    {
+        std::lock_guard<std::mutex> lock(sessions_mtx_);
+        sessions.reserve(sessions_.size());
+        for (const auto& [id, s] : sessions_) sessions.push_back(s);
+    }
+    const Series session_series[] = {
+        { "game_session_messages_in_total",  "TCP messages received, by session.", &TrafficCounters::messages_in },
+        { "game_session_bytes_in_total",     "TCP bytes received, by session.",    &TrafficCounters::bytes_in },
+        { "game_session_messages_out_total", "TCP messages queued, by session.",   &TrafficCounters::messages_out },
+        { "game_session_bytes_out_total",    "TCP bytes queued, by session.",      &TrafficCounters::bytes_out },
+    };
+    for (const auto& s : session_series) {
+        os << "# HELP " << s.metric << " " << s.help << "\n"
+           << "# TYPE " << s.metric << " counter\n";
+        for (const auto& st : sessions)
+            os << s.metric << "{player=\"" << st->player_id << "\"} " << load(st->traffic.*s.field) << "\n";
+    }
+    const Series session_udp_series[] = {
+        { "game_session_udp_datagrams_in_total",  "UDP datagrams received, by session.", &TrafficCounters::messages_in },
+        { "game_session_udp_bytes_in_total",      "UDP bytes received, by session.",     &TrafficCounters::bytes_in },
+        { "game_session_udp_datagrams_out_total", "UDP datagrams sent, by session.",     &TrafficCounters::messages_out },
+        { "game_session_udp_bytes_out_total",     "UDP bytes sent, by session.",         &TrafficCounters::bytes_out },
+    };
+    for (const auto& s : session_udp_series) {
+        os << "# HELP " << s.metric << " " << s.help << "\n"
+           << "# TYPE " << s.metric << " counter\n";
+        for (const auto& st : sessions)
+            os << s.metric << "{player=\"" << st->player_id << "\"} " << load(st->udp.*s.field) << "\n";
+    }
+    os << "# HELP game_session_reliable_window Reliable UDP messages awaiting an ack, by session.\n"
+       << "# TYPE game_session_reliable_window gauge\n";
+    for (const auto& st : sessions)
+        os << "game_session_reliable_window{player=\"" << st->player_id << "\"} " << load(st->reliable_window) << "\n";
+    os << "# HELP game_session_write_queue_depth Messages waiting in a session's TCP write queue.\n"
+       << "# TYPE game_session_write_queue_depth gauge\n";
+    for (const auto& st : sessions)
+        os << "game_session_write_queue_depth{player=\"" << st->player_id << "\"} " << load(st->write_queue_depth) << "\n";
+    os << "# HELP game_session_write_queue_max Deepest TCP write queue seen for a session.\n"
+       << "# TYPE game_session_write_queue_max gauge\n";
+    for (const auto& st : sessions)
+        os << "game_session_write_queue_max{player=\"" << st->player_id << "\"} " << load(st->write_queue_max) << "\n";
+    os << "# HELP game_session_rtt_seconds Smoothed round-trip time of a session's UDP link.\n"
+       << "# TYPE game_session_rtt_seconds gauge\n";
+    for (const auto& st : sessions)
+        os << "game_session_rtt_seconds{player=\"" << st->player_id << "\"} " << load(st->rtt_us) / 1e6 << "\n";
+    os << "# HELP game_session_rtt_jitter_seconds Round-trip time variation of a session's UDP link.\n"
+       << "# TYPE game_session_rtt_jitter_seconds gauge\n";
+    for (const auto& st : sessions)
+        os << "game_session_rtt_jitter_seconds{player=\"" << st->player_id << "\"} " << load(st->rtt_jitter_us) / 1e6 << "\n";
+
+    return os.str();
+}
@@ -0,0 +1,164 @@
+// Metrics.h
+// Lock-free server counters and latency histograms, rendered in Prometheus text format.
+//
+// Recording is a handful of relaxed atomic adds so it is safe from the tick, the
+// TCP session handlers and the UDP receive path. Rendering walks the same atomics
+// and may run concurrently with recording (values are a best-effort snapshot).
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "../shared/protocol.h"
+
+// ---------------------- Histogram ----------------------
+
+// HDR-style log-linear histogram of nanosecond values: 32 linear sub-buckets per
+// power of two (~3% relative error) from 1ns up to ~2^42ns (~73 minutes).
+class Histogram {
+public:
+    static constexpr int kSubBits = 5;
+    static constexpr uint64_t kSubCount = 1ull << kSubBits;
+    static constexpr int kMaxMsb = 42;
+    static constexpr std::size_t kBucketCount = (kMaxMsb - kSubBits + 2) * kSubCount;
+
+    void record(uint64_t value_ns);
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    // Value at quantile q in [0, 1], reported as the midpoint of its bucket
+    uint64_t percentile(double q) const;
+
+    static std::size_t bucket_index(uint64_t v);
+    static uint64_t bucket_lower(std::size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketCount> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+// ---------------------- Traffic counters ----------------------
+
+struct TrafficCounters {
+    std::atomic<uint64_t> messages_in{0};
+    std::atomic<uint64_t> bytes_in{0};
+    std::atomic<uint64_t> messages_out{0};
+    std::atomic<uint64_t> bytes_out{0};
+
+    void add_in(std::size_t bytes) {
+        messages_in.fetch_add(1, std::memory_order_relaxed);
+        bytes_in.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    void add_out(std::size_t bytes) {
+        messages_out.fetch_add(1, std::memory_order_relaxed);
+        bytes_out.fetch_add(bytes, std::memory_order_relaxed);
+    }
+};
+
+// Shared between a Session and the Metrics registry while the player is connected
+struct SessionStats {
+    explicit SessionStats(uint32_t id) : player_id(id) {}
+
+    const uint32_t player_id;
+    TrafficCounters traffic;
+    std::atomic<uint64_t> write_queue_depth{0};
+    std::atomic<uint64_t> write_queue_max{0};
+    std::atomic<uint64_t> rtt_us{0};         // smoothed, from Ping/Pong
+    std::atomic<uint64_t> rtt_jitter_us{0};
+    TrafficCounters udp;                     // datagrams and bytes of the player's UDP slot
+    std::atomic<uint64_t> reliable_window{0}; // unacked reliable UDP messages
+
+    void set_write_queue_depth(std::size_t depth);
+};
+
+// ---------------------- Metrics ----------------------
+
+enum class TickPhase : uint8_t {
+    Input,       // handle_msg, per accepted message
+    Simulation,  // lobby/match state machine, respawns
+    Replication, // building the PlayerState snapshot
+    Send,        // serialize + queue TCP broadcast and UDP stream
+    Total,       // whole tick()
+    Count
+};
+
+const char* tick_phase_name(TickPhase p);
+
+class Metrics {
+public:
+    explicit Metrics(std::chrono::nanoseconds tick_budget) : tick_budget_(tick_budget) {}
+
+    Histogram& phase(TickPhase p) { return phases_[static_cast<std::size_t>(p)]; }
+    void record_tick(std::chrono::nanoseconds total);
+
+    // By message type: TCP counts include the length header, UDP ones the channel header
+    enum class Transport : uint8_t { Tcp, Udp };
+    void message_in(MessageType t, std::size_t bytes, Transport via = Transport::Tcp) {
+        by_type_[static_cast<std::size_t>(via)][static_cast<uint8_t>(t)].add_in(bytes);
+    }
+    void message_out(MessageType t, std::size_t bytes, Transport via = Transport::Tcp) {
+        by_type_[static_cast<std::size_t>(via)][static_cast<uint8_t>(t)].add_out(bytes);
+    }
+
+    // UDP datagrams
+    void udp_in(std::size_t bytes) { udp_.add_in(bytes); }
+    void udp_out(std::size_t bytes) { udp_.add_out(bytes); }
+    void udp_drop() { udp_drops_.fetch_add(1, std::memory_order_relaxed); }
+    void udp_send_error() { udp_send_errors_.fetch_add(1, std::memory_order_relaxed); }
+    void udp_send_deferred() { udp_send_deferred_.fetch_add(1, std::memory_order_relaxed); } // backpressure, not an error
+
+    // Ping/Pong round trips, all sessions
+    Histogram& rtt() { return rtt_; }
+
+    void set_connected_players(std::size_t n) { connected_players_.store(n, std::memory_order_relaxed); }
+
+    std::shared_ptr<SessionStats> register_session(uint32_t player_id);
+    void unregister_session(uint32_t player_id);
+
+    std::string render_prometheus() const;
+
+private:
+    const std::chrono::nanoseconds tick_budget_;
+
+    std::array<Histogram, static_cast<std::size_t>(TickPhase::Count)> phases_;
+    std::atomic<uint64_t> ticks_{0};
+    std::atomic<uint64_t> tick_overruns_{0};
+
+    std::array<std::array<TrafficCounters, 256>, 2> by_type_; // [Transport][MessageType]
+    TrafficCounters udp_;
+    std::atomic<uint64_t> udp_drops_{0};
+    std::atomic<uint64_t> udp_send_errors_{0};
+    std::atomic<uint64_t> udp_send_deferred_{0};
+    std::atomic<uint64_t> connected_players_{0};
+    Histogram rtt_;
+
+    mutable std::mutex sessions_mtx_;
+    std::unordered_map<uint32_t, std::shared_ptr<SessionStats>> sessions_;
+};
+
+// Times a scope into one histogram
+class ScopedPhaseTimer {
+public:
+    explicit ScopedPhaseTimer(Histogram& h) : h_(h), t0_(std::chrono::steady_clock::now()) {}
+    ~ScopedPhaseTimer() {
+        auto dt = std::chrono::steady_clock::now() - t0_;
+        h_.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(dt).count()));
+    }
+    ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+    ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+private:
+    Histogram& h_;
+    std::chrono::steady_clock::time_point t0_;
+};
@@ -0,0 +1,139 @@
+// MetricsExporter.cpp
+// Minimal HTTP/1.0 responder for Prometheus scrapes plus the periodic stats file.
+
+#include "MetricsExporter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include "../shared/log.h"
+#include "../shared/trace.h"
+
+using boost::asio::ip::tcp;
+
+// One request: read the request head, answer, close.
+//   GET /metrics            Prometheus text
+//   GET /trace?seconds=N    capture N seconds (default 10) and return Chrome trace JSON
+class MetricsExporter::Connection : public std::enable_shared_from_this<Connection> {
+public:
+    Connection(tcp::socket socket, const Metrics& metrics)
+        : socket_(std::move(socket)), metrics_(metrics) {}
+
+    void start() {
+        auto self = shared_from_this();
+        boost::asio::async_read_until(socket_, request_, "\r\n\r\n",
+            [this, self](boost::system::error_code ec, std::size_t /*n*/) {
+                if (ec) return;
+                std::istream is(&request_);
+                std::string method, path;
+                is >> method >> path;
+                if (method != "GET") respond("404 Not Found", "text/plain", "not found\n");
+                else if (path == "/metrics" || path == "/")
+                    respond("200 OK", "text/plain; version=0.0.4", metrics_.render_prometheus());
+                else if (path.compare(0, 6, "/trace") == 0) capture_trace(path);
+                else respond("404 Not Found", "text/plain", "not found\n");
+            });
+    }
+
+private:
+    void capture_trace(const std::string& path) {
+        if (!trace::kCompiledIn) {
+            respond("501 Not Implemented", "text/plain", "server built without GAME_ENABLE_TRACING\n");
+            return;
+        }
+        if (trace::capturing()) {
+            respond("409 Conflict", "text/plain", "a trace capture is already running\n");
+            return;
+        }
+
+        int seconds = 10;
+        auto q = path.find("seconds=");
+        if (q != std::string::npos) seconds = std::atoi(path.c_str() + q + 8);
+        seconds = std::clamp(seconds, 1, 60);
+
+        trace::start();
+        timer_ = std::make_unique<boost::asio::steady_timer>(socket_.get_executor(), std::chrono::seconds(seconds));
+        auto self = shared_from_this();
+        timer_->async_wait([this, self](const boost::system::error_code&) {
+            trace::stop();
+            // Up to kRingCapacity events per thread: serialized here on the metrics thread,
+            // never on the io thread whose ticks the capture is measuring
+            respond("200 OK", "application/json", trace::to_chrome_json("server"));
+        });
+    }
+
+    void respond(const char* status, const char* content_type, const std::string& body) {
+        response_ = std::string("HTTP/1.0 ") + status + "\r\n"
+                  + "Content-Type: " + content_type + "\r\n"
+                  + "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                  + "Connection: close\r\n\r\n"
+                  + body;
+
+        auto self = shared_from_this();
+        boost::asio::async_write(socket_, boost::asio::buffer(response_),
+            [this, self](boost::system::error_code, std::size_t) {
+                boost::system::error_code ignored;
+                socket_.shutdown(tcp::socket::shutdown_both, ignored);
+            });
+    }
+
+    tcp::socket socket_;
+    const Metrics& metrics_;
+    boost::asio::streambuf request_{8192};
+    std::string response_;
+    std::unique_ptr<boost::asio::steady_timer> timer_;
+};
+
+MetricsExporter::MetricsExporter(const Metrics& metrics, unsigned short http_port, std::string stats_file,
+                                 std::chrono::seconds stats_interval)
+    : metrics_(metrics),
+      stats_timer_(io_),
+      stats_file_(std::move(stats_file)),
+      stats_interval_(stats_interval) {
+    if (http_port != 0) {
+        // Loopback only: the endpoint is for a local agent / port-forward, not the internet
+        acceptor_ = std::make_unique<tcp::acceptor>(
+            io_, tcp::endpoint(boost::asio::ip::address_v4::loopback(), http_port));
+        do_accept();
+    }
+    if (!stats_file_.empty()) boost::asio::post(io_, [this]() { write_stats_file(); });
+
+    thread_ = std::thread([this]() {
+        trace::set_thread_name("metrics");
+        try {
+            io_.run();
+        } catch (const std::exception& e) {
+            LOG_ERROR("[Server] Metrics exporter stopped: {}", e.what());
+        }
+    });
+}
+
+MetricsExporter::~MetricsExporter() {
+    io_.stop();
+    if (thread_.joinable()) thread_.join();
+}
+
+void MetricsExporter::do_accept() {
+    acceptor_->async_accept([this](boost::system::error_code ec, tcp::socket sock) {
+        if (!ec) std::make_shared<Connection>(std::move(sock), metrics_)->start();
+        do_accept();
+    });
+}
+
+void MetricsExporter::write_stats_file() {
+    // Write then rename so readers never observe a half-written file
+    const std::string tmp = stats_file_ + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        if (out) out << metrics_.render_prometheus();
+    }
+    if (std::rename(tmp.c_str(), stats_file_.c_str()) != 0) {
+        LOG_WARN("[Server] Could not write stats file {}", stats_file_);
+    }
+
+    stats_timer_.expires_after(stats_interval_);
+    stats_timer_.async_wait([this](const boost::system::error_code& ec) {
+        if (!ec) write_stats_file();
+    });
+}
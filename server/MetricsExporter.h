@@ -0,0 +1,41 @@
+// MetricsExporter.h
+// Serves Metrics over a loopback HTTP endpoint (GET /metrics) and/or rewrites a
+// stats file periodically. Runs its own io_context on a "metrics" thread, so file IO
+// and response building never delay the game's tick; a scrape only reads atomics.
+
+#pragma once
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "Metrics.h"
+
+constexpr unsigned short kDefaultMetricsPort = 9339;
+
+class MetricsExporter {
+public:
+    // http_port 0 disables the endpoint, an empty stats_file disables the file.
+    MetricsExporter(const Metrics& metrics, unsigned short http_port, std::string stats_file,
+                    std::chrono::seconds stats_interval = std::chrono::seconds(5));
+    ~MetricsExporter(); // stops and joins the thread
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+private:
+    class Connection;
+
+    void do_accept();
+    void write_stats_file();
+
+    const Metrics& metrics_;
+    boost::asio::io_context io_;
+    std::unique_ptr<boost::asio::ip::tcp::acceptor> acceptor_;
+    boost::asio::steady_timer stats_timer_;
+    std::string stats_file_;
+    std::chrono::seconds stats_interval_;
+    std::thread thread_; // last: starts once everything above is constructed
+};
@@ -0,0 +1,58 @@
+// Serialization.h
+// Wire helpers shared by the server, benchmarks and tools (must match client).
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "../shared/protocol.h"
+#include "../shared/reliable_udp.h"
+
+// ---------------------- TCP body: 4-byte type + payload ----------------------
+
+inline std::vector<char> serialize_game_message(const GameMessage& m) {
+    std::vector<char> body(sizeof(uint32_t) + sizeof(m.data));
+    uint32_t t = static_cast<uint32_t>(m.type);
+    std::memcpy(body.data(), &t, sizeof(uint32_t));
+    std::memcpy(body.data() + sizeof(uint32_t), &m.data, sizeof(m.data));
+    return body;
+}
+
+inline GameMessage deserialize_game_message(const std::vector<char>& body) {
+    GameMessage m{};
+    if (body.size() != sizeof(uint32_t) + sizeof(m.data))
+        throw std::runtime_error("invalid TCP body size");
+    uint32_t t = 0;
+    std::memcpy(&t, body.data(), sizeof(uint32_t));
+    m.type = static_cast<MessageType>(t);
+    std::memcpy(&m.data, body.data() + sizeof(uint32_t), sizeof(m.data));
+    return m;
+}
+
+// ---------------------- UDP datagram ----------------------
+
+inline std::vector<char> serialize_udp_message(const UDPMessage& u) {
+    std::vector<char> buf(sizeof(UDPMessage));
+    std::memcpy(buf.data(), &u, sizeof(UDPMessage));
+    return buf;
+}
+
+inline UDPMessage deserialize_udp_message(const char* data, std::size_t len) {
+    if (len != sizeof(UDPMessage)) throw std::runtime_error("invalid UDP size");
+    UDPMessage u{};
+    std::memcpy(&u, data, sizeof(UDPMessage));
+    return u;
+}
+
+// Client -> server datagrams: UdpHeader + reliable_udp.h packet
+constexpr std::size_t kMaxClientDatagramSize = sizeof(UdpHeader) + kMaxPacketSize;
+
+// Reads only the header; the caller validates slot and token before touching the packet
+inline bool read_udp_header(const char* data, std::size_t len, UdpHeader& h) {
+    if (len < sizeof(UdpHeader) + sizeof(PacketHeader) || len > kMaxClientDatagramSize) return false;
+    std::memcpy(&h, data, sizeof(UdpHeader));
+    return true;
+}
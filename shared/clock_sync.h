@@ -0,0 +1,98 @@
+#pragma once
+// Round-trip time and server clock estimation from Ping/Pong timestamp echoes.
+//
+// Either side may send Ping{id, sent_us} on the unreliable UDP channel; the peer
+// answers at once with Pong echoing both fields, so the sender gets an RTT sample
+// from its own clock alone. A server Pong also carries the current tick and how far
+// into it the server was, which lets the client estimate the server tick at any
+// local time (ServerClockEstimator).
+//
+// Timestamps are steady_clock microseconds of the side that sent the Ping; the two
+// clocks are never compared directly.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+inline uint64_t steady_now_us() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Smoothed RTT and jitter as in RFC 6298 (srtt gain 1/8, rttvar gain 1/4)
+class RttEstimator {
+public:
+    void add_sample(double rtt_ms) {
+        if (samples_ == 0) {
+            srtt_ = rtt_ms;
+            jitter_ = rtt_ms / 2.0;
+            min_ = rtt_ms;
+        } else {
+            jitter_ += (std::abs(srtt_ - rtt_ms) - jitter_) * 0.25;
+            srtt_ += (rtt_ms - srtt_) * 0.125;
+            min_ = std::min(min_, rtt_ms);
+        }
+        ++samples_;
+    }
+
+    double srtt_ms() const { return srtt_; }
+    double jitter_ms() const { return jitter_; }
+    double min_ms() const { return min_; }
+    uint64_t samples() const { return samples_; }
+
+private:
+    double srtt_ = 0.0;
+    double jitter_ = 0.0;
+    double min_ = 0.0;
+    uint64_t samples_ = 0;
+};
+
+// Client side: maps local time to the server tick. Each Pong gives the local time at
+// which server tick 0 began, assuming the reply took half the RTT; of the last
+// kWindow Pongs the one with the smallest RTT is trusted, as its one-way split
+// guess is the least wrong. Updated by the network thread, read from any thread.
+class ServerClockEstimator {
+public:
+    explicit ServerClockEstimator(double tick_us) : tick_us_(tick_us) {}
+
+    void on_pong(uint64_t ping_sent_us, uint64_t received_us, uint32_t server_tick, uint32_t tick_age_us) {
+        if (received_us < ping_sent_us) return;
+        const double rtt_us = static_cast<double>(received_us - ping_sent_us);
+        const double server_elapsed_us = server_tick * tick_us_ + tick_age_us + rtt_us / 2.0;
+        const double origin_us = static_cast<double>(received_us) - server_elapsed_us;
+        if (next_ > 0 && std::abs(origin_us - origin_us_.load(std::memory_order_relaxed)) > 1e6)
+            next_ = 0; // off by over a second: the server restarted, forget the old samples
+        window_[next_ % kWindow] = { rtt_us, origin_us };
+        ++next_;
+
+        const std::size_t n = std::min<std::size_t>(next_, kWindow);
+        const Sample* best = &window_[0];
+        for (std::size_t i = 1; i < n; ++i)
+            if (window_[i].rtt_us < best->rtt_us) best = &window_[i];
+        origin_us_.store(best->origin_us, std::memory_order_relaxed);
+        synced_.store(true, std::memory_order_release);
+    }
+
+    bool synced() const { return synced_.load(std::memory_order_acquire); }
+
+    // Estimated (fractional) server tick at local time now_us
+    double server_tick(uint64_t now_us) const {
+        return (static_cast<double>(now_us) - origin_us_.load(std::memory_order_relaxed)) / tick_us_;
+    }
+
+private:
+    struct Sample {
+        double rtt_us;
+        double origin_us; // local time at which server tick 0 began
+    };
+    static constexpr std::size_t kWindow = 8;
+
+    const double tick_us_;
+    std::array<Sample, kWindow> window_{};
+    std::size_t next_ = 0;
+    std::atomic<double> origin_us_{0.0};
+    std::atomic<bool> synced_{false};
+};
@@ -0,0 +1,99 @@
+#pragma once
+// Redundant input: the client samples input once per server tick and every
+// PlayerInputFrames message repeats the newest MAX_INPUT_FRAMES frames, so a lost
+// datagram is covered by the next one without waiting for a retransmit. The server
+// keeps the highest sequence it has queued and ignores the copies it already has.
+//
+// Frames are written newest first. Each one is a flags byte (bits 0-3 up, down, left,
+// right; bit 4 rotation follows) and, when flagged, the 16-byte rotation. The newest
+// frame always carries its rotation; an older one only if it differs from the frame
+// after it, which is rare while a key is held and the mouse is still.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+#include "protocol.h"
+
+// Input sampling period: one frame per server tick
+constexpr std::chrono::microseconds kInputFrameInterval{SERVER_TICK_US};
+
+namespace input_frames_detail {
+constexpr uint8_t kUp = 1 << 0, kDown = 1 << 1, kLeft = 1 << 2, kRight = 1 << 3, kHasRotation = 1 << 4;
+}
+
+// Client side: history of sampled frames and the message for the newest ones
+class InputFrameHistory {
+public:
+    // Records the input for the next tick and returns its sequence number (starts at 1)
+    uint32_t push(const PlayerInputData& in) {
+        frames_[sequence_ % MAX_INPUT_FRAMES] = in;
+        if (count_ < MAX_INPUT_FRAMES) ++count_;
+        return ++sequence_;
+    }
+
+    uint32_t newest_sequence() const { return sequence_; }
+
+    GameMessage make_message() const {
+        using namespace input_frames_detail;
+        PlayerInputFramesData d{};
+        d.newest_sequence = sequence_;
+        d.count = static_cast<uint8_t>(count_);
+
+        std::size_t pos = 0;
+        const PlayerInputData* newer = nullptr;
+        for (int i = 0; i < count_; ++i) {
+            const PlayerInputData& f = frames_[(sequence_ - 1 - i) % MAX_INPUT_FRAMES];
+            uint8_t flags = (f.up ? kUp : 0) | (f.down ? kDown : 0) | (f.left ? kLeft : 0) | (f.right ? kRight : 0);
+            const bool rotation = !newer || std::memcmp(&newer->rotation, &f.rotation, sizeof(glm::quat)) != 0;
+            if (rotation) flags |= kHasRotation;
+            d.bytes[pos++] = flags;
+            if (rotation) {
+                std::memcpy(d.bytes + pos, &f.rotation, sizeof(glm::quat));
+                pos += sizeof(glm::quat);
+            }
+            newer = &f;
+        }
+        d.size = static_cast<uint8_t>(pos);
+
+        GameMessage msg{};
+        msg.type = MessageType::PlayerInputFrames;
+        msg.setData(d);
+        return msg;
+    }
+
+private:
+    PlayerInputData frames_[MAX_INPUT_FRAMES]{};
+    uint32_t sequence_ = 0;
+    int count_ = 0;
+};
+
+// Server side: decodes up to MAX_INPUT_FRAMES frames, newest first; frame i has
+// sequence newest_sequence - i. Returns the number decoded, stopping at malformed data.
+inline int decode_input_frames(const PlayerInputFramesData& d, PlayerInputData out[MAX_INPUT_FRAMES]) {
+    using namespace input_frames_detail;
+    const std::size_t size = std::min<std::size_t>(d.size, sizeof(d.bytes));
+    const int count = std::min<int>(d.count, MAX_INPUT_FRAMES);
+
+    std::size_t pos = 0;
+    for (int i = 0; i < count; ++i) {
+        if (pos >= size) return i;
+        const uint8_t flags = d.bytes[pos++];
+        PlayerInputData& f = out[i];
+        f.up = flags & kUp;
+        f.down = flags & kDown;
+        f.left = flags & kLeft;
+        f.right = flags & kRight;
+        if (flags & kHasRotation) {
+            if (size - pos < sizeof(glm::quat)) return i;
+            std::memcpy(&f.rotation, d.bytes + pos, sizeof(glm::quat));
+            pos += sizeof(glm::quat);
+        } else if (i > 0) {
+            f.rotation = out[i - 1].rotation;
+        } else {
+            return 0; // the newest frame must carry its rotation
+        }
+    }
+    return count;
+}
@@ -0,0 +1,288 @@
+#pragma once
+// Asynchronous logging that never blocks the calling thread.
+//
+//   LOG_INFO("Player {} joined.", id);
+//   LOG_ERROR("TCP write error: {}", ec.message());
+//   logging::set_level(logging::Level::Warn);
+//
+// A call site copies its arguments (numbers, and strings truncated to kMaxString) into
+// the calling thread's lock-free single-producer ring and returns. Formatting, ordering
+// across threads and the write to stdout/stderr all happen on a background writer
+// thread. If a ring is full the record is dropped and counted rather than waiting.
+// Warn and Error sites are rate limited per call site (kSiteBurst per second); the
+// number of suppressed lines is reported with the next line that gets through.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace logging {
+
+enum class Level : uint8_t { Debug, Info, Warn, Error, Off };
+
+constexpr std::size_t kMaxString = 160;     // per string argument, longer strings are cut
+constexpr uint32_t kSiteBurst = 10;         // Warn/Error lines per call site per second
+
+namespace detail {
+
+constexpr std::size_t kRingCapacity = 1024; // records per thread
+constexpr std::size_t kPayloadBytes = 232;  // encoded arguments per record
+
+enum ArgTag : uint8_t { TagI64, TagU64, TagF64, TagStr };
+
+struct Record {
+    uint64_t time_ns;
+    const char* fmt;       // string literal from the call site
+    Level level;
+    uint8_t argc;
+    uint16_t size;         // used bytes of payload
+    uint32_t suppressed;   // lines dropped by this site's rate limit since the last one
+    char payload[kPayloadBytes];
+};
+
+struct ThreadRing {
+    std::unique_ptr<Record[]> slots{ new Record[kRingCapacity] };
+    std::atomic<uint64_t> head{0}; // written by the owning thread
+    std::atomic<uint64_t> tail{0}; // written by the writer thread
+};
+
+inline uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+// ---------------------- argument encoding ----------------------
+
+inline void put(Record& r, const void* p, std::size_t n) {
+    if (r.size + n > kPayloadBytes) n = kPayloadBytes - r.size;
+    std::memcpy(r.payload + r.size, p, n);
+    r.size = static_cast<uint16_t>(r.size + n);
+}
+
+inline void encode_str(Record& r, const char* s, std::size_t len) {
+    len = std::min(len, kMaxString);
+    if (r.size + 2 + len > kPayloadBytes) return; // out of room: argument prints as empty
+    uint8_t tag = TagStr, n = static_cast<uint8_t>(len);
+    put(r, &tag, 1);
+    put(r, &n, 1);
+    put(r, s, len);
+    ++r.argc;
+}
+
+template <typename T>
+void encode_num(Record& r, uint8_t tag, T v) {
+    if (r.size + 1 + sizeof(T) > kPayloadBytes) return;
+    put(r, &tag, 1);
+    put(r, &v, sizeof(T));
+    ++r.argc;
+}
+
+inline void encode(Record& r, const std::string& s) { encode_str(r, s.data(), s.size()); }
+inline void encode(Record& r, const char* s) { encode_str(r, s ? s : "(null)", s ? strnlen(s, kMaxString) : 6); }
+inline void encode(Record& r, char* s) { encode(r, static_cast<const char*>(s)); }
+inline void encode(Record& r, bool b) { encode_str(r, b ? "true" : "false", b ? 4 : 5); }
+
+template <typename T>
+std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>> encode(Record& r, T v) {
+    if constexpr (std::is_enum_v<T>) encode(r, static_cast<std::underlying_type_t<T>>(v));
+    else if constexpr (std::is_floating_point_v<T>) encode_num(r, TagF64, static_cast<double>(v));
+    else if constexpr (std::is_signed_v<T>) encode_num(r, TagI64, static_cast<int64_t>(v));
+    else encode_num(r, TagU64, static_cast<uint64_t>(v));
+}
+
+// ---------------------- formatting (writer thread) ----------------------
+
+inline void append_arg(std::string& out, const Record& r, std::size_t& pos) {
+    if (pos >= r.size) return;
+    uint8_t tag = static_cast<uint8_t>(r.payload[pos++]);
+    char buf[32];
+    switch (tag) {
+        case TagI64: { int64_t v; std::memcpy(&v, r.payload + pos, sizeof(v)); pos += sizeof(v);
+                       std::snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(v)); out += buf; } break;
+        case TagU64: { uint64_t v; std::memcpy(&v, r.payload + pos, sizeof(v)); pos += sizeof(v);
+                       std::snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(v)); out += buf; } break;
+        case TagF64: { double v; std::memcpy(&v, r.payload + pos, sizeof(v)); pos += sizeof(v);
+                       std::snprintf(buf, sizeof(buf), "%g", v); out += buf; } break;
+        case TagStr: { uint8_t n = static_cast<uint8_t>(r.payload[pos++]);
+                       out.append(r.payload + pos, n); pos += n; } break;
+        default: pos = r.size; break;
+    }
+}
+
+inline std::string format(const Record& r) {
+    static const char* kNames[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+
+    std::time_t secs = static_cast<std::time_t>(r.time_ns / 1000000000ull);
+    std::tm tm{};
+#ifdef _WIN32
+    localtime_s(&tm, &secs);
+#else
+    localtime_r(&secs, &tm);
+#endif
+    char stamp[48];
+    std::snprintf(stamp, sizeof(stamp), "%02d:%02d:%02d.%03u %-5s ", tm.tm_hour, tm.tm_min, tm.tm_sec,
+                  static_cast<unsigned>((r.time_ns / 1000000ull) % 1000), kNames[static_cast<int>(r.level)]);
+
+    std::string out = stamp;
+    std::size_t pos = 0;
+    for (const char* f = r.fmt; *f; ++f) {
+        if (f[0] == '{' && f[1] == '}') { append_arg(out, r, pos); ++f; }
+        else out += *f;
+    }
+    if (r.suppressed) out += " (" + std::to_string(r.suppressed) + " similar lines suppressed)";
+    out += '\n';
+    return out;
+}
+
+// ---------------------- registry and writer thread ----------------------
+
+class Logger {
+public:
+    Logger() : writer_([this] { run(); }) {}
+    ~Logger() {
+        stopping_.store(true, std::memory_order_release);
+        writer_.join();
+    }
+
+    std::atomic<Level> level{Level::Info};
+    std::atomic<uint64_t> dropped{0};
+
+    ThreadRing& ring() {
+        thread_local std::shared_ptr<ThreadRing> r = [this] {
+            auto ring = std::make_shared<ThreadRing>();
+            std::lock_guard<std::mutex> lock(mtx_);
+            rings_.push_back(ring);
+            return ring;
+        }();
+        return *r;
+    }
+
+private:
+    void run() {
+        std::vector<Record> batch;
+        for (;;) {
+            bool stop = stopping_.load(std::memory_order_acquire);
+            drain(batch);
+            if (stop) return;
+            if (batch.empty()) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    // Pull everything published so far, order it by time and write it out
+    void drain(std::vector<Record>& batch) {
+        batch.clear();
+        {
+            std::lock_guard<std::mutex> lock(mtx_); // guards the ring list, never held by producers
+            for (const auto& r : rings_) {
+                uint64_t tail = r->tail.load(std::memory_order_relaxed);
+                const uint64_t head = r->head.load(std::memory_order_acquire);
+                for (; tail < head; ++tail) batch.push_back(r->slots[tail % kRingCapacity]);
+                r->tail.store(tail, std::memory_order_release);
+            }
+        }
+        std::stable_sort(batch.begin(), batch.end(),
+                         [](const Record& a, const Record& b) { return a.time_ns < b.time_ns; });
+
+        FILE* last = nullptr;
+        for (const Record& r : batch) {
+            const std::string line = format(r);
+            FILE* f = r.level >= Level::Warn ? stderr : stdout;
+            if (last && f != last) std::fflush(last); // keep stdout/stderr interleaving in time order
+            std::fwrite(line.data(), 1, line.size(), f);
+            last = f;
+        }
+        if (last) std::fflush(last);
+        if (uint64_t n = dropped.exchange(0, std::memory_order_relaxed)) {
+            std::fprintf(stderr, "[log] %llu lines dropped (ring full)\n", static_cast<unsigned long long>(n));
+        }
+    }
+
+    std::mutex mtx_;
+    std::vector<std::shared_ptr<ThreadRing>> rings_;
+    std::atomic<bool> stopping_{false};
+    std::thread writer_;
+};
+
+inline Logger& logger() {
+    static Logger l;
+    return l;
+}
+
+// Per call site rate limit state for Warn/Error
+struct Site {
+    std::atomic<uint64_t> window{0};   // second the current burst belongs to
+    std::atomic<uint32_t> count{0};    // lines emitted in that second
+    std::atomic<uint32_t> suppressed{0};
+
+    // Returns false if the line should be dropped; otherwise sets how many were dropped before it
+    bool admit(uint64_t time_ns, uint32_t& suppressed_out) {
+        const uint64_t sec = time_ns / 1000000000ull;
+        uint64_t w = window.load(std::memory_order_relaxed);
+        if (w != sec && window.compare_exchange_strong(w, sec, std::memory_order_relaxed))
+            count.store(0, std::memory_order_relaxed);
+        if (count.fetch_add(1, std::memory_order_relaxed) >= kSiteBurst) {
+            suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        suppressed_out = suppressed.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+};
+
+template <typename... Args>
+void write(Site& site, Level level, const char* fmt, const Args&... args) {
+    Logger& l = logger();
+    const uint64_t t = now_ns();
+    uint32_t suppressed = 0;
+    if (level >= Level::Warn && !site.admit(t, suppressed)) return;
+
+    ThreadRing& ring = l.ring();
+    const uint64_t head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) >= kRingCapacity) {
+        l.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Record& r = ring.slots[head % kRingCapacity];
+    r.time_ns = t;
+    r.fmt = fmt;
+    r.level = level;
+    r.argc = 0;
+    r.size = 0;
+    r.suppressed = suppressed;
+    (encode(r, args), ...);
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+} // namespace detail
+
+inline void set_level(Level level) { detail::logger().level.store(level, std::memory_order_relaxed); }
+
+inline bool enabled(Level level) {
+    return level >= detail::logger().level.load(std::memory_order_relaxed) && level != Level::Off;
+}
+
+} // namespace logging
+
+// The format must be a string literal; each {} is replaced by the next argument.
+#define LOG_AT(lvl, ...)                                                        \
+    do {                                                                        \
+        if (::logging::enabled(lvl)) {                                          \
+            static ::logging::detail::Site log_site_;                           \
+            ::logging::detail::write(log_site_, lvl, __VA_ARGS__);              \
+        }                                                                       \
+    } while (0)
+
+#define LOG_DEBUG(...) LOG_AT(::logging::Level::Debug, __VA_ARGS__)
+#define LOG_INFO(...)  LOG_AT(::logging::Level::Info, __VA_ARGS__)
+#define LOG_WARN(...)  LOG_AT(::logging::Level::Warn, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(::logging::Level::Error, __VA_ARGS__)
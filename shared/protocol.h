@@ -1,4 +1,6 @@
 #pragma once
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <vector>
@@ -8,9 +10,11 @@
 
 constexpr int MAX_PLAYERS = 16;
 constexpr int MAX_CHAT_MESSAGE_LENGTH = 128;
+constexpr int MAX_INPUT_FRAMES = 8;     // redundant input frames per PlayerInputFrames message
 constexpr int TCP_PORT = 1337;
 constexpr int UDP_PORT = 1338;
 constexpr int GAME_VERSION = 1;
+constexpr int SERVER_TICK_US = 16000;   // server tick length (kTickInterval in server/Game.h)
 
 // ---------------- Message Types ----------------
 enum class MessageType : uint8_t {
@@ -27,9 +31,35 @@ enum class MessageType : uint8_t {
     PlayerRespawn,
     GameStateUpdate,
     ClientReady,
-    ChatMessage
+    ChatMessage,
+    PlayerInputFrames,
+    Ping,
+    Pong
 };
 
+inline const char* message_type_name(MessageType t) {
+    switch (t) {
+        case MessageType::Handshake:       return "Handshake";
+        case MessageType::HandshakeResult: return "HandshakeResult";
+        case MessageType::PlayerJoin:      return "PlayerJoin";
+        case MessageType::PlayerLeave:     return "PlayerLeave";
+        case MessageType::PlayerState:     return "PlayerState";
+        case MessageType::AllPlayersState: return "AllPlayersState";
+        case MessageType::PlayerInput:     return "PlayerInput";
+        case MessageType::PlayerShoot:     return "PlayerShoot";
+        case MessageType::ProjectileSpawn: return "ProjectileSpawn";
+        case MessageType::PlayerHit:       return "PlayerHit";
+        case MessageType::PlayerRespawn:   return "PlayerRespawn";
+        case MessageType::GameStateUpdate: return "GameStateUpdate";
+        case MessageType::ClientReady:     return "ClientReady";
+        case MessageType::ChatMessage:     return "ChatMessage";
+        case MessageType::PlayerInputFrames: return "PlayerInputFrames";
+        case MessageType::Ping:            return "Ping";
+        case MessageType::Pong:            return "Pong";
+    }
+    return "Unknown";
+}
+
 enum class GameState : uint8_t {
     LOBBY,
     IN_PROGRESS,
@@ -41,9 +71,14 @@ struct HandshakeData {
     uint32_t version;
 };
 
+// Server reply to Handshake. On success the client tags every UDP datagram with
+// udp_slot/udp_token (UdpHeader) so the server can find its session without a lookup.
 struct HandshakeResultData {
     bool success;
     char message[MAX_CHAT_MESSAGE_LENGTH];
+    uint32_t player_id;
+    uint16_t udp_slot;
+    uint32_t udp_token;
 };
 
 struct PlayerInputData {
@@ -68,6 +103,7 @@ struct PlayerStateData {
 
 struct AllPlayersStateData {
     int count;
+    uint32_t tick;          // server tick the snapshot was taken on (client interpolation)
     PlayerStateData players[MAX_PLAYERS];
 };
 
@@ -101,6 +137,53 @@ struct ChatMessageData {
 
 struct PlayerShootData { };
 
+// The newest `count` input frames, newest first, delta-encoded (see shared/input_frames.h).
+// Only the used part of bytes goes on the wire (message_wire_size).
+struct PlayerInputFramesData {
+    uint32_t newest_sequence;
+    uint8_t count;
+    uint8_t size;
+    uint8_t bytes[MAX_INPUT_FRAMES * (1 + sizeof(glm::quat))];
+};
+
+// RTT probe, answered immediately with a Pong (see shared/clock_sync.h). sent_us is
+// the sender's steady clock and only ever compared against that same clock.
+struct PingData {
+    uint32_t id;
+    uint64_t sent_us;
+};
+
+struct PongData {
+    uint32_t id;
+    uint64_t ping_sent_us;  // echoed from the Ping
+    uint32_t server_tick;   // server replies only: current tick...
+    uint32_t tick_age_us;   // ...and time since it started
+};
+
+// Bytes of GameMessage::data that carry the payload for a given message type
+inline std::size_t message_payload_size(MessageType t) {
+    switch (t) {
+        case MessageType::Handshake:       return sizeof(HandshakeData);
+        case MessageType::HandshakeResult: return sizeof(HandshakeResultData);
+        case MessageType::PlayerJoin:      return sizeof(PlayerStateData);
+        case MessageType::PlayerLeave:     return sizeof(uint32_t);
+        case MessageType::PlayerState:     return sizeof(AllPlayersStateData);
+        case MessageType::AllPlayersState: return sizeof(AllPlayersStateData);
+        case MessageType::PlayerInput:     return sizeof(PlayerInputData);
+        case MessageType::PlayerShoot:     return 0;
+        case MessageType::ProjectileSpawn: return sizeof(ProjectileData);
+        case MessageType::PlayerHit:       return sizeof(PlayerHitData);
+        case MessageType::PlayerRespawn:   return sizeof(PlayerRespawnData);
+        case MessageType::GameStateUpdate: return sizeof(GameStateData);
+        case MessageType::ClientReady:     return 0;
+        case MessageType::ChatMessage:     return sizeof(ChatMessageData);
+        case MessageType::PlayerInputFrames: return sizeof(PlayerInputFramesData);
+        case MessageType::Ping:            return sizeof(PingData);
+        case MessageType::Pong:            return sizeof(PongData);
+    }
+    return 0;
+}
+
 // ---------------- GameMessage Wrapper ----------------
 struct GameMessage {
     MessageType type;
@@ -120,26 +203,57 @@ struct GameMessage {
         return d;
     }
 
+    // TCP body size on the wire: 4-byte type + data (must match server/Serialization.h)
+    static constexpr std::size_t kWireSize = sizeof(uint32_t) + sizeof(data);
+
     // ---- Serialize to raw buffer ----
     std::vector<char> serialize() const {
-        std::vector<char> buffer(sizeof(MessageType) + sizeof(data));
-        std::memcpy(buffer.data(), &type, sizeof(MessageType));
-        std::memcpy(buffer.data() + sizeof(MessageType), data, sizeof(data));
+        std::vector<char> buffer(kWireSize);
+        uint32_t t = static_cast<uint32_t>(type);
+        std::memcpy(buffer.data(), &t, sizeof(uint32_t));
+        std::memcpy(buffer.data() + sizeof(uint32_t), data, sizeof(data));
         return buffer;
     }
 
-    // ---- Deserialize from raw buffer ----
+    // ---- Deserialize from raw buffer (kWireSize bytes) ----
     static GameMessage deserialize(const char* buffer) {
         GameMessage msg;
-        std::memcpy(&msg.type, buffer, sizeof(MessageType));
-        std::memcpy(msg.data, buffer + sizeof(MessageType), sizeof(msg.data));
+        uint32_t t = 0;
+        std::memcpy(&t, buffer, sizeof(uint32_t));
+        msg.type = static_cast<MessageType>(t);
+        std::memcpy(msg.data, buffer + sizeof(uint32_t), sizeof(msg.data));
         return msg;
     }
 };
 
+// Bytes of GameMessage::data worth sending: the payload, minus unused tails of
+// variable-length payloads
+inline std::size_t message_wire_size(const GameMessage& m) {
+    if (m.type == MessageType::PlayerInputFrames) {
+        uint8_t used = 0;
+        std::memcpy(&used, m.data + offsetof(PlayerInputFramesData, size), 1);
+        return offsetof(PlayerInputFramesData, bytes) + std::min<std::size_t>(used, sizeof(PlayerInputFramesData::bytes));
+    }
+    if (m.type == MessageType::PlayerState || m.type == MessageType::AllPlayersState) {
+        int count = 0;
+        std::memcpy(&count, m.data + offsetof(AllPlayersStateData, count), sizeof(int));
+        return offsetof(AllPlayersStateData, players) + std::clamp(count, 0, MAX_PLAYERS) * sizeof(PlayerStateData);
+    }
+    return message_payload_size(m.type);
+}
+
 // ---------------- UDP Message ----------------
 struct UDPMessage {
     uint32_t player_id;
     glm::vec3 position;
     glm::quat rotation;
 };
+
+// Prefix of every client -> server datagram: the slot and token issued in
+// HandshakeResultData. The server indexes its slot table directly and drops the
+// datagram unless the token matches.
+struct UdpHeader {
+    uint16_t slot;
+    uint16_t reserved;
+    uint32_t token;
+};
@@ -0,0 +1,424 @@
+#pragma once
+// Lightweight reliability layer over UDP, shared by Game and NetworkClient.
+//
+// Every packet carries a 16-bit sequence number plus an ack of the newest packet
+// received from the peer and a 32-bit bitfield for the 32 before it, so acks ride on
+// ordinary traffic. A packet holds any number of messages, each on a logical channel:
+//
+//   Unreliable         sent once, newest state wins (PlayerState, redundant input, ping/pong)
+//   ReliableUnordered  resent until acked, delivered on arrival, duplicates dropped
+//   ReliableOrdered    resent until acked, delivered in send order
+//
+// Only reliable messages that were in lost packets are resent (selective resend),
+// after a timeout derived from the smoothed RTT.
+//
+// Packet:  u16 sequence (never 0), u16 ack (0 = none yet), u32 ack_bits, then messages:
+//          u8 channel, u8 type, u16 message_id, u16 size, payload
+//
+// One ReliableEndpoint per peer; not thread-safe, use it from a single thread/strand.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "protocol.h"
+
+enum class Channel : uint8_t {
+    Unreliable,
+    ReliableUnordered,
+    ReliableOrdered,
+    Count
+};
+
+// Channel a message type takes when the peer has a UDP link. Session lifecycle
+// messages return false and stay on TCP, where they are ordered with PlayerJoin/Leave.
+inline bool udp_channel_for(MessageType t, Channel& out) {
+    switch (t) {
+        case MessageType::PlayerState:
+        case MessageType::AllPlayersState:
+        case MessageType::PlayerInput:
+        case MessageType::PlayerInputFrames:
+        case MessageType::Ping:
+        case MessageType::Pong:            out = Channel::Unreliable; return true;
+        case MessageType::PlayerShoot:
+        case MessageType::ProjectileSpawn:
+        case MessageType::PlayerHit:
+        case MessageType::PlayerRespawn:   out = Channel::ReliableUnordered; return true;
+        case MessageType::ClientReady:
+        case MessageType::ChatMessage:     out = Channel::ReliableOrdered; return true;
+        default:                           return false;
+    }
+}
+
+// Unreliable types whose newest message carries everything an older one did (a whole
+// snapshot, or the last MAX_INPUT_FRAMES inputs). Queueing one replaces any older one
+// still waiting, so a delayed packet never spends its room on stale state.
+inline bool supersedes_queued(MessageType t) {
+    return t == MessageType::PlayerState || t == MessageType::AllPlayersState ||
+           t == MessageType::PlayerInputFrames;
+}
+
+struct PacketHeader {
+    uint16_t sequence;
+    uint16_t ack;
+    uint32_t ack_bits;
+};
+
+struct ChannelMessageHeader {
+    uint8_t channel;
+    uint8_t type;
+    uint16_t message_id;
+    uint16_t size;
+};
+
+constexpr std::size_t kMaxPacketSize = 1400; // under a 1500-byte MTU
+// Reliable bytes a packet always has room for, however much unreliable data is queued.
+// A 16-player PlayerState (8 + 16 * 72 payload bytes) leaves about this much anyway.
+constexpr std::size_t kMinReliableBytes = 200;
+
+// Wrap-around comparison for 16-bit sequence numbers / message ids
+inline bool sequence_greater(uint16_t a, uint16_t b) {
+    return ((a > b) && (a - b <= 32768)) || ((a < b) && (b - a > 32768));
+}
+
+class ReliableEndpoint {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t kWindow = 256;      // unacked reliable messages per channel
+    static constexpr std::size_t kRefsPerPacket = 32; // reliable messages tracked per packet
+
+    struct Stats {
+        uint64_t packets_sent = 0;
+        uint64_t packets_received = 0;
+        uint64_t packets_acked = 0;
+        uint64_t resends = 0;
+        uint64_t unreliable_dropped = 0; // did not fit in the packet
+        uint64_t unreliable_superseded = 0; // replaced by a newer one before it was sent
+    };
+
+    // Queues a message for the next packet. Returns false if a reliable channel's
+    // window is full; the caller should fall back to another transport.
+    bool send(Channel ch, const GameMessage& msg) {
+        return send(ch, msg.type, msg.data, message_wire_size(msg));
+    }
+
+    // Same, from an already encoded payload of `size` bytes
+    bool send(Channel ch, MessageType type, const char* payload, std::size_t size) {
+        if (ch == Channel::Unreliable) {
+            if (supersedes_queued(type)) drop_queued_unreliable(type);
+            ChannelMessageHeader h{ static_cast<uint8_t>(ch), static_cast<uint8_t>(type), 0,
+                                    static_cast<uint16_t>(size) };
+            const std::size_t at = unreliable_.size();
+            unreliable_.resize(at + sizeof(h) + size);
+            std::memcpy(unreliable_.data() + at, &h, sizeof(h));
+            std::memcpy(unreliable_.data() + at + sizeof(h), payload, size);
+            return true;
+        }
+
+        SendChannel& c = send_[static_cast<int>(ch)];
+        if (static_cast<uint16_t>(c.next_id - c.oldest_unacked) >= kWindow) return false;
+        Pending& p = c.ring[c.next_id % kWindow];
+        p.used = true;
+        p.id = c.next_id++;
+        p.type = type;
+        p.payload.assign(payload, payload + size);
+        p.last_sent = Clock::time_point{};
+        return true;
+    }
+
+    // Builds the next packet (acks, queued unreliable messages, reliable messages due
+    // for first send or resend) into out. Returns the number of bytes written.
+    std::size_t write_packet(Clock::time_point now, char* out, std::size_t cap) {
+        return write_packet(now, out, cap, [](MessageType, std::size_t) {});
+    }
+
+    // Same, calling on_write(MessageType, bytes) for each message written (bytes
+    // includes its ChannelMessageHeader), for per-type traffic accounting
+    template <typename OnWrite>
+    std::size_t write_packet(Clock::time_point now, char* out, std::size_t cap, OnWrite&& on_write) {
+        cap = std::min(cap, kMaxPacketSize);
+        PacketHeader ph{ local_sequence_, remote_sequence_, ack_bits_ };
+        std::memcpy(out, &ph, sizeof(ph));
+        std::size_t len = sizeof(ph);
+
+        SentPacket& sp = sent_[local_sequence_ % kWindow];
+        sp = SentPacket{};
+        sp.valid = true;
+        sp.sequence = local_sequence_;
+        sp.time = now;
+
+        // Reliable messages go first but leave room for this packet's unreliable ones (the
+        // newest state), down to kMinReliableBytes; what does not fit waits for the next packet
+        const std::size_t reliable_cap =
+            cap - std::min(unreliable_.size(), cap - std::min(cap, len + kMinReliableBytes));
+        const auto resend_after = resend_timeout();
+        for (int ch = static_cast<int>(Channel::ReliableUnordered); ch < static_cast<int>(Channel::Count); ++ch) {
+            SendChannel& c = send_[ch];
+            for (uint16_t id = c.oldest_unacked; id != c.next_id && sp.ref_count < kRefsPerPacket; ++id) {
+                Pending& p = c.ring[id % kWindow];
+                if (!p.used || p.id != id) continue;
+                const bool first = p.last_sent == Clock::time_point{};
+                if (!first && now - p.last_sent < resend_after) continue;
+
+                const std::size_t need = sizeof(ChannelMessageHeader) + p.payload.size();
+                if (len + need > reliable_cap) break;
+                ChannelMessageHeader h{ static_cast<uint8_t>(ch), static_cast<uint8_t>(p.type), p.id,
+                                        static_cast<uint16_t>(p.payload.size()) };
+                std::memcpy(out + len, &h, sizeof(h));
+                std::memcpy(out + len + sizeof(h), p.payload.data(), p.payload.size());
+                len += need;
+                on_write(p.type, need);
+
+                if (!first) ++stats_.resends;
+                p.last_sent = now;
+                sp.refs[sp.ref_count++] = { static_cast<uint8_t>(ch), p.id };
+            }
+        }
+
+        // Unreliable messages in queue order, at most one of each superseding type (send()
+        // replaced older ones); whatever does not fit is dropped
+        std::size_t pos = 0;
+        while (pos < unreliable_.size()) {
+            ChannelMessageHeader h;
+            std::memcpy(&h, unreliable_.data() + pos, sizeof(h));
+            const std::size_t need = sizeof(h) + h.size;
+            if (len + need <= cap) {
+                std::memcpy(out + len, unreliable_.data() + pos, need);
+                len += need;
+                on_write(static_cast<MessageType>(h.type), need);
+            } else {
+                ++stats_.unreliable_dropped;
+            }
+            pos += need;
+        }
+        unreliable_.clear();
+
+        if (++local_sequence_ == 0) local_sequence_ = 1; // 0 is reserved for "nothing received"
+        ++stats_.packets_sent;
+        return len;
+    }
+
+    // Parses a packet from the peer, processes its acks and calls deliver(const GameMessage&)
+    // for each message that should be delivered now. Returns false if the packet is malformed.
+    template <typename Deliver>
+    bool read_packet(const char* data, std::size_t len, Clock::time_point now, Deliver&& deliver) {
+        if (len < sizeof(PacketHeader)) return false;
+        PacketHeader ph;
+        std::memcpy(&ph, data, sizeof(ph));
+
+        if (!mark_received(ph.sequence)) return true; // duplicate or too old: nothing new inside
+        ++stats_.packets_received;
+        process_acks(ph.ack, ph.ack_bits, now);
+
+        std::size_t pos = sizeof(ph);
+        while (pos < len) {
+            if (len - pos < sizeof(ChannelMessageHeader)) return false;
+            ChannelMessageHeader h;
+            std::memcpy(&h, data + pos, sizeof(h));
+            pos += sizeof(h);
+            if (h.size > sizeof(GameMessage::data) || len - pos < h.size ||
+                h.channel >= static_cast<uint8_t>(Channel::Count)) return false;
+
+            GameMessage msg{};
+            msg.type = static_cast<MessageType>(h.type);
+            std::memcpy(msg.data, data + pos, h.size);
+            pos += h.size;
+
+            switch (static_cast<Channel>(h.channel)) {
+                case Channel::Unreliable:
+                    deliver(msg);
+                    break;
+                case Channel::ReliableUnordered: {
+                    auto& seen = unordered_seen_[h.message_id % kWindow];
+                    if (seen == static_cast<int32_t>(h.message_id)) break; // duplicate
+                    seen = h.message_id;
+                    deliver(msg);
+                } break;
+                case Channel::ReliableOrdered:
+                    receive_ordered(h.message_id, msg, deliver);
+                    break;
+                default: break;
+            }
+        }
+        return true;
+    }
+
+    // Smoothed round-trip time from acked packets, 0 until the first ack
+    double rtt_ms() const { return rtt_ms_; }
+    // Reliable messages sent or queued but not yet acked, all channels
+    std::size_t reliable_in_flight() const {
+        std::size_t n = 0;
+        for (int ch = static_cast<int>(Channel::ReliableUnordered); ch < static_cast<int>(Channel::Count); ++ch)
+            n += static_cast<uint16_t>(send_[ch].next_id - send_[ch].oldest_unacked);
+        return n;
+    }
+    const Stats& stats() const { return stats_; }
+
+private:
+    struct Pending {
+        bool used = false;
+        uint16_t id = 0;
+        MessageType type{};
+        std::vector<char> payload;
+        Clock::time_point last_sent{};
+    };
+
+    struct SendChannel {
+        uint16_t next_id = 0;
+        uint16_t oldest_unacked = 0;
+        std::array<Pending, kWindow> ring{};
+    };
+
+    struct MessageRef {
+        uint8_t channel;
+        uint16_t id;
+    };
+
+    struct SentPacket {
+        bool valid = false;
+        bool acked = false;
+        uint16_t sequence = 0;
+        Clock::time_point time{};
+        uint8_t ref_count = 0;
+        std::array<MessageRef, kRefsPerPacket> refs{};
+    };
+
+    struct OrderedSlot {
+        bool used = false;
+        MessageType type{};
+        std::vector<char> payload;
+    };
+
+    void drop_queued_unreliable(MessageType type) {
+        std::size_t pos = 0;
+        while (pos < unreliable_.size()) {
+            ChannelMessageHeader h;
+            std::memcpy(&h, unreliable_.data() + pos, sizeof(h));
+            const std::size_t size = sizeof(h) + h.size;
+            if (h.type == static_cast<uint8_t>(type)) {
+                unreliable_.erase(unreliable_.begin() + pos, unreliable_.begin() + pos + size);
+                ++stats_.unreliable_superseded;
+            } else {
+                pos += size;
+            }
+        }
+    }
+
+    Clock::duration resend_timeout() const {
+        using ms = std::chrono::duration<double, std::milli>;
+        const double t = rtt_ms_ > 0.0 ? std::clamp(rtt_ms_ * 1.5 + 5.0, 20.0, 250.0) : 100.0;
+        return std::chrono::duration_cast<Clock::duration>(ms(t));
+    }
+
+    // Updates remote_sequence_/ack_bits_; false if the packet was already seen or is too old to ack
+    bool mark_received(uint16_t seq) {
+        if (seq == 0) return false;
+        if (!have_remote_) {
+            have_remote_ = true;
+            remote_sequence_ = seq;
+            ack_bits_ = 0;
+            return true;
+        }
+        if (sequence_greater(seq, remote_sequence_)) {
+            const uint16_t shift = static_cast<uint16_t>(seq - remote_sequence_);
+            ack_bits_ = shift > 32 ? 0 : ((shift == 32 ? 0 : ack_bits_ << shift) | (1u << (shift - 1)));
+            remote_sequence_ = seq;
+            return true;
+        }
+        const uint16_t back = static_cast<uint16_t>(remote_sequence_ - seq);
+        if (back == 0 || back > 32) return false;
+        const uint32_t bit = 1u << (back - 1);
+        if (ack_bits_ & bit) return false;
+        ack_bits_ |= bit;
+        return true;
+    }
+
+    void process_acks(uint16_t ack, uint32_t bits, Clock::time_point now) {
+        ack_one(ack, now, true);
+        for (uint16_t i = 0; i < 32; ++i)
+            if (bits & (1u << i)) ack_one(static_cast<uint16_t>(ack - 1 - i), now, false);
+    }
+
+    void ack_one(uint16_t seq, Clock::time_point now, bool newest) {
+        SentPacket& sp = sent_[seq % kWindow];
+        if (!sp.valid || sp.sequence != seq || sp.acked) return;
+        sp.acked = true;
+        ++stats_.packets_acked;
+
+        if (newest) {
+            const double sample = std::chrono::duration<double, std::milli>(now - sp.time).count();
+            rtt_ms_ = rtt_ms_ == 0.0 ? sample : rtt_ms_ + 0.1 * (sample - rtt_ms_);
+        }
+
+        for (uint8_t i = 0; i < sp.ref_count; ++i) {
+            SendChannel& c = send_[sp.refs[i].channel];
+            Pending& p = c.ring[sp.refs[i].id % kWindow];
+            if (p.used && p.id == sp.refs[i].id) {
+                p.used = false;
+                p.payload.clear();
+            }
+        }
+        // Slide each window past acked messages
+        for (int ch = static_cast<int>(Channel::ReliableUnordered); ch < static_cast<int>(Channel::Count); ++ch) {
+            SendChannel& c = send_[ch];
+            while (c.oldest_unacked != c.next_id) {
+                const Pending& p = c.ring[c.oldest_unacked % kWindow];
+                if (p.used && p.id == c.oldest_unacked) break;
+                ++c.oldest_unacked;
+            }
+        }
+    }
+
+    template <typename Deliver>
+    void receive_ordered(uint16_t id, const GameMessage& msg, Deliver& deliver) {
+        if (sequence_greater(next_ordered_, id)) return;                          // already delivered
+        if (static_cast<uint16_t>(id - next_ordered_) >= kWindow) return;          // too far ahead, sender resends
+        if (id == next_ordered_) { // common case: in order, no buffering
+            deliver(msg);
+            ++next_ordered_;
+        } else {
+            OrderedSlot& s = ordered_[id % kWindow];
+            if (s.used) return;
+            s.used = true;
+            s.type = msg.type;
+            s.payload.assign(msg.data, msg.data + message_wire_size(msg));
+            return;
+        }
+        while (ordered_[next_ordered_ % kWindow].used) {
+            OrderedSlot& next = ordered_[next_ordered_ % kWindow];
+            GameMessage out{};
+            out.type = next.type;
+            std::memcpy(out.data, next.payload.data(), next.payload.size());
+            next.used = false;
+            deliver(out);
+            ++next_ordered_;
+        }
+    }
+
+    // Outgoing
+    uint16_t local_sequence_ = 1;
+    std::vector<char> unreliable_;
+    std::array<SendChannel, static_cast<int>(Channel::Count)> send_{};
+    std::array<SentPacket, kWindow> sent_{};
+
+    // Incoming
+    bool have_remote_ = false;
+    uint16_t remote_sequence_ = 0; // 0 acks nothing until the first packet arrives
+    uint32_t ack_bits_ = 0;
+    std::array<int32_t, kWindow> unordered_seen_ = make_unseen();
+    uint16_t next_ordered_ = 0;
+    std::vector<OrderedSlot> ordered_ = std::vector<OrderedSlot>(kWindow);
+
+    double rtt_ms_ = 0.0;
+    Stats stats_;
+
+    static std::array<int32_t, kWindow> make_unseen() {
+        std::array<int32_t, kWindow> a;
+        a.fill(-1);
+        return a;
+    }
+};
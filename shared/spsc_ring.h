@@ -0,0 +1,58 @@
+#pragma once
+// Bounded single-producer/single-consumer ring.
+//
+// One thread calls try_push, one other thread calls try_pop; neither ever blocks or
+// allocates after construction. A full ring rejects the push and the producer decides
+// what to do with it (NetworkClient drops and counts). Capacity must be a power of two.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+template <typename T, std::size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    static constexpr std::size_t capacity() { return Capacity; }
+
+    // Producer thread only
+    bool try_push(const T& v) {
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - cached_tail_ == Capacity) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head - cached_tail_ == Capacity) return false;
+        }
+        slots_[head & (Capacity - 1)] = v;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only
+    bool try_pop(T& out) {
+        const uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == cached_head_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail == cached_head_) return false;
+        }
+        out = slots_[tail & (Capacity - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called from a third thread
+    std::size_t size() const {
+        return static_cast<std::size_t>(head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire));
+    }
+
+private:
+    std::unique_ptr<T[]> slots_{ new T[Capacity] };
+
+    // Producer and consumer indices on separate cache lines, each with the side's
+    // cached copy of the other index so the fast path touches only its own line.
+    alignas(64) std::atomic<uint64_t> head_{0};
+    uint64_t cached_tail_ = 0;
+    alignas(64) std::atomic<uint64_t> tail_{0};
+    uint64_t cached_head_ = 0;
+};
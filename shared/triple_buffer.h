@@ -0,0 +1,42 @@
+#pragma once
+// Single-producer/single-consumer "latest value" channel.
+//
+// Three slots: the producer owns one and fills it, the consumer owns one and reads it,
+// and the third is the hand-over. publish() swaps the producer's slot with the hand-over
+// one and consume() swaps the consumer's with it, each with one atomic exchange, so
+// neither side ever waits for the other. Values the consumer was too slow to see are
+// overwritten (only the newest matters), and slots are reused, so a T that owns
+// containers keeps their capacity and steady-state publishing does not allocate.
+
+#include <atomic>
+#include <cstdint>
+
+template <typename T>
+class TripleBuffer {
+public:
+    // Producer thread only: the slot to fill; holds whatever was published three times ago
+    T& write_slot() { return slots_[write_]; }
+    void publish() {
+        const uint8_t previous = middle_.exchange(static_cast<uint8_t>(write_ | kFresh), std::memory_order_acq_rel);
+        write_ = previous & kIndexMask;
+    }
+
+    // Consumer thread only: takes the newest published value if there is one since the
+    // last call; read_slot() is that value (or the previous one on false)
+    bool consume() {
+        if (!(middle_.load(std::memory_order_relaxed) & kFresh)) return false;
+        const uint8_t previous = middle_.exchange(read_, std::memory_order_acq_rel);
+        read_ = previous & kIndexMask;
+        return true;
+    }
+    const T& read_slot() const { return slots_[read_]; }
+
+private:
+    static constexpr uint8_t kIndexMask = 0x3;
+    static constexpr uint8_t kFresh = 0x4; // the hand-over slot holds a value not yet consumed
+
+    T slots_[3];
+    uint8_t write_ = 0;                 // producer's
+    alignas(64) std::atomic<uint8_t> middle_{1};
+    alignas(64) uint8_t read_ = 2;      // consumer's
+};